@@ -0,0 +1,310 @@
+/**
+ * @file bench.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Throughput of the pager frontend over the software backend. Each operation
+ * is timed over ranges of 4K, 2M and 1G pages, laid out sequentially, every
+ * other page, or at random, on 4 and 5 level tables. The best of a few runs is
+ * reported per page and per call, along with the shootdowns requested.
+*/
+#include "arch/pager.h"
+#include "host.h"
+#include "softpager.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_RUNS 5
+// Where ranges are mapped, and where pager_map points them
+#define BENCH_VIRTUAL 0x0000100000000000ULL
+#define BENCH_PHYSICAL 0x0000004000000000ULL
+// Where pager_clone puts its copies
+#define BENCH_CLONE 0x0000200000000000ULL
+
+enum {
+	BENCH_SEQUENTIAL,
+	BENCH_STRIDED,
+	BENCH_RANDOM,
+	BENCH_PATTERN_MAX,
+};
+
+enum {
+	BENCH_MAP,
+	BENCH_SET_ATTR,
+	BENCH_CLONE_SHARE,
+	BENCH_UNMAP,
+	BENCH_FLY_MAP,
+	BENCH_CLONE_COW,
+	BENCH_FLY_UNMAP,
+	BENCH_OP_MAX,
+};
+
+struct bench_size {
+	const char *name;
+	size_t size;
+	uint32_t attributes;
+	// Pages the ranges cover
+	size_t pages;
+};
+
+struct bench_range {
+	uintptr_t offset;
+	size_t size;
+};
+
+struct bench_result {
+	uint64_t ns;
+	size_t shootdowns;
+};
+
+static const struct bench_size bench_sizes[] = {
+	{ "4K", 0x1000, 1 << ARC_PAGER_4K, 8192 },
+	{ "2M", 0x200000, 0, 512 },
+	{ "1G", 0x40000000, 0, 16 },
+};
+
+static const char *bench_pattern_names[BENCH_PATTERN_MAX] = { "sequential", "strided", "random" };
+static const char *bench_op_names[BENCH_OP_MAX] = { "map", "set_attr", "clone", "unmap", "fly_map", "clone_cow", "fly_unmap" };
+
+static uint64_t bench_seed = 0x9E3779B97F4A7C15;
+
+static uint64_t bench_random() {
+	bench_seed ^= bench_seed << 13;
+	bench_seed ^= bench_seed >> 7;
+	bench_seed ^= bench_seed << 17;
+
+	return bench_seed;
+}
+
+static uint64_t bench_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Lay out the ranges of a pattern, returning how many there are. They start a
+// page in, so that a sequential range of one size is not mapped with larger
+// pages
+static size_t bench_layout(const struct bench_size *size, int pattern, struct bench_range *ranges) {
+	switch (pattern) {
+		case BENCH_SEQUENTIAL: {
+			ranges[0] = (struct bench_range){ size->size, size->pages * size->size };
+			return 1;
+		}
+
+		case BENCH_STRIDED: {
+			for (size_t i = 0; i < size->pages; i++) {
+				ranges[i] = (struct bench_range){ (2 * i + 1) * size->size, size->size };
+			}
+
+			return size->pages;
+		}
+
+		default: {
+			// A shuffle of every other slot, so that the pages are as sparse
+			// as with BENCH_STRIDED
+			for (size_t i = 0; i < size->pages; i++) {
+				ranges[i] = (struct bench_range){ (2 * i + 1) * size->size, size->size };
+			}
+
+			for (size_t i = size->pages - 1; i > 0; i--) {
+				size_t j = bench_random() % (i + 1);
+				struct bench_range swap = ranges[i];
+				ranges[i] = ranges[j];
+				ranges[j] = swap;
+			}
+
+			return size->pages;
+		}
+	}
+}
+
+static bool bench_check_pages(void *page_tables, const struct bench_size *size, size_t expected) {
+	ARC_PagerStats stats = { 0 };
+
+	if (pager_get_stats(page_tables, &stats) != 0) {
+		return false;
+	}
+
+	size_t pages = stats.pages_4k;
+
+	if (size->size == 0x200000) {
+		pages = stats.pages_2m;
+	} else if (size->size == 0x40000000) {
+		pages = stats.pages_1g;
+	}
+
+	return pages == expected && stats.pages_4k + stats.pages_2m + stats.pages_1g == expected;
+}
+
+// Run every operation once over the ranges, in an order that leaves nothing
+// mapped behind
+static int bench_run(const struct bench_size *size, struct bench_range *ranges, size_t count, struct bench_result *results) {
+	void *tables = pager_create_page_tables();
+	void *clone = pager_create_page_tables();
+	uint32_t attributes = size->attributes | (1 << ARC_PAGER_RW);
+	int ret = 0;
+
+	for (int op = 0; op < BENCH_OP_MAX; op++) {
+		// Frames are only ever given out 4K at a time
+		if (op >= BENCH_FLY_MAP && size->size != 0x1000) {
+			results[op] = (struct bench_result){ 0 };
+			continue;
+		}
+
+		size_t shootdowns = Arc_HostCounters.shootdowns;
+		uint64_t start = bench_now();
+
+		for (size_t i = 0; i < count && ret == 0; i++) {
+			uintptr_t virtual = BENCH_VIRTUAL + ranges[i].offset;
+			uintptr_t copy = BENCH_CLONE + ranges[i].offset;
+
+			switch (op) {
+				case BENCH_MAP: {
+					ret = pager_map(tables, virtual, BENCH_PHYSICAL + ranges[i].offset, ranges[i].size, attributes);
+					break;
+				}
+
+				case BENCH_SET_ATTR: {
+					ret = pager_set_attr(tables, virtual, ranges[i].size, attributes | (1 << ARC_PAGER_NX));
+					break;
+				}
+
+				case BENCH_CLONE_SHARE: {
+					ret = pager_clone(clone, tables, virtual, copy, ranges[i].size, 0);
+					break;
+				}
+
+				case BENCH_UNMAP: {
+					ret = pager_unmap(tables, virtual, ranges[i].size, NULL);
+					break;
+				}
+
+				case BENCH_FLY_MAP: {
+					ret = pager_fly_map(tables, virtual, ranges[i].size, attributes);
+					break;
+				}
+
+				case BENCH_CLONE_COW: {
+					ret = pager_clone(clone, tables, virtual, copy, ranges[i].size, 1 << ARC_PAGER_CLONE_COW);
+					break;
+				}
+
+				case BENCH_FLY_UNMAP: {
+					// The copies first, so that the frames are freed with
+					// the originals
+					ret = pager_fly_unmap(clone, copy, ranges[i].size) | pager_fly_unmap(tables, virtual, ranges[i].size);
+					break;
+				}
+			}
+		}
+
+		results[op].ns = bench_now() - start;
+		results[op].shootdowns = Arc_HostCounters.shootdowns - shootdowns;
+
+		if (ret != 0) {
+			fprintf(stderr, "%s of %s pages failed\n", bench_op_names[op], size->name);
+			break;
+		}
+
+		// The copies are dropped outside of the timing, for the next clone
+		if (op == BENCH_CLONE_SHARE) {
+			for (size_t i = 0; i < count; i++) {
+				pager_unmap(clone, BENCH_CLONE + ranges[i].offset, ranges[i].size, NULL);
+			}
+		}
+
+		size_t expected = op == BENCH_UNMAP || op == BENCH_FLY_UNMAP ? 0 : size->pages;
+
+		if (!bench_check_pages(tables, size, expected)) {
+			fprintf(stderr, "%s of %s pages left the wrong pages mapped\n", bench_op_names[op], size->name);
+			ret = -1;
+			break;
+		}
+	}
+
+	pager_delete_page_tables(clone);
+	pager_delete_page_tables(tables);
+
+	return ret;
+}
+
+int main() {
+	if (init_pager_pool(1) != 0) {
+		return 1;
+	}
+
+	printf("%-6s %-4s %-10s %-10s %12s %12s %12s\n", "levels", "page", "pattern", "operation", "ns/page", "ns/call", "shootdowns");
+
+	for (int levels = 4; levels <= 5; levels++) {
+		if (pager_set_backend(softpager_get_backend(levels)) != 0) {
+			return 1;
+		}
+
+		for (size_t s = 0; s < sizeof(bench_sizes) / sizeof(*bench_sizes); s++) {
+			const struct bench_size *size = &bench_sizes[s];
+			struct bench_range *ranges = malloc(size->pages * sizeof(*ranges));
+
+			if (ranges == NULL) {
+				return 1;
+			}
+
+			for (int pattern = 0; pattern < BENCH_PATTERN_MAX; pattern++) {
+				size_t count = bench_layout(size, pattern, ranges);
+				struct bench_result best[BENCH_OP_MAX] = { 0 };
+
+				for (int run = 0; run < BENCH_RUNS; run++) {
+					struct bench_result results[BENCH_OP_MAX];
+
+					if (bench_run(size, ranges, count, results) != 0) {
+						return 1;
+					}
+
+					for (int op = 0; op < BENCH_OP_MAX; op++) {
+						if (run == 0 || results[op].ns < best[op].ns) {
+							best[op] = results[op];
+						}
+					}
+				}
+
+				for (int op = 0; op < BENCH_OP_MAX; op++) {
+					if (op >= BENCH_FLY_MAP && size->size != 0x1000) {
+						continue;
+					}
+
+					printf("%-6d %-4s %-10s %-10s %12.1f %12.1f %12zu\n", levels, size->name, bench_pattern_names[pattern],
+					       bench_op_names[op], (double)best[op].ns / size->pages, (double)best[op].ns / count, best[op].shootdowns);
+				}
+			}
+
+			free(ranges);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file host.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Host implementations of the kernel functions the pager frontend uses. The
+ * benchmark runs on a single thread, standing in for processor 0.
+*/
+#include "host.h"
+#include "arch/smp.h"
+
+#include <stdlib.h>
+
+#define HOST_PAGE_SIZE 0x1000
+
+ARC_HostCounters Arc_HostCounters = { 0 };
+
+void *host_alloc(size_t size) {
+	if (size < HOST_PAGE_SIZE) {
+		return malloc(size);
+	}
+
+	return aligned_alloc(HOST_PAGE_SIZE, (size + HOST_PAGE_SIZE - 1) & ~(size_t)(HOST_PAGE_SIZE - 1));
+}
+
+void *host_calloc(size_t count, size_t size) {
+	return calloc(count, size);
+}
+
+void host_free(void *address) {
+	free(address);
+}
+
+uint32_t smp_get_processor_id() {
+	return 0;
+}
+
+int smp_tlb_shootdown(void *page_tables, int kind, uintptr_t start, uintptr_t end, bool freed_tables) {
+	(void)page_tables;
+	(void)kind;
+	(void)start;
+	(void)end;
+
+	Arc_HostCounters.shootdowns++;
+
+	if (freed_tables) {
+		Arc_HostCounters.table_shootdowns++;
+	}
+
+	return 0;
+}
+
+void smp_tlb_forget(void *page_tables) {
+	(void)page_tables;
+}
+
+int smp_tlb_release(void *page_tables) {
+	(void)page_tables;
+
+	Arc_HostCounters.shootdowns++;
+	Arc_HostCounters.table_shootdowns++;
+
+	return 0;
+}
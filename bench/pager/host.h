@@ -0,0 +1,43 @@
+/**
+ * @file host.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Host implementations of the kernel functions the pager frontend uses,
+ * counting the shootdowns it requests.
+*/
+#ifndef ARC_BENCH_HOST_H
+#define ARC_BENCH_HOST_H
+
+#include <stddef.h>
+
+typedef struct ARC_HostCounters {
+        // smp_tlb_shootdown and smp_tlb_release calls, and those of them for
+        // freed tables
+        size_t shootdowns;
+        size_t table_shootdowns;
+} ARC_HostCounters;
+
+extern ARC_HostCounters Arc_HostCounters;
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file arctan.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Host stand-in for the kernel's arctan.h, providing the architecture types
+ * the included arch headers refer to.
+*/
+#ifndef ARC_BENCH_ARCTAN_H
+#define ARC_BENCH_ARCTAN_H
+
+#include <stdint.h>
+
+typedef struct ARC_Registers {
+        uint64_t unused;
+} ARC_Registers;
+
+typedef struct ARC_InterruptFrame {
+        ARC_Registers gpr;
+} ARC_InterruptFrame;
+
+typedef struct ARC_Context {
+        void *page_tables;
+} ARC_Context;
+
+typedef struct ARC_ProcessorFeatures {
+        uint64_t unused;
+} ARC_ProcessorFeatures;
+
+#endif
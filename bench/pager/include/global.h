@@ -0,0 +1,43 @@
+/**
+ * @file global.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Host stand-in for the kernel's global.h. The HHDM is the identity, so
+ * pointers from the allocator serve as physical addresses.
+*/
+#ifndef ARC_BENCH_GLOBAL_H
+#define ARC_BENCH_GLOBAL_H
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ARC_HHDM_VADDR 0
+#define ARC_HHDM_TO_PHYS(__address) ((uintptr_t)(__address) - ARC_HHDM_VADDR)
+#define ARC_PHYS_TO_HHDM(__address) ((uintptr_t)(__address) + ARC_HHDM_VADDR)
+
+#define ARC_DEBUG(__level, ...) fprintf(stderr, #__level ": " __VA_ARGS__)
+
+#endif
@@ -0,0 +1,46 @@
+/**
+ * @file allocator.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Host stand-in for the kernel's allocator, routed to host_alloc and
+ * friends so as not to collide with the C library.
+*/
+#ifndef ARC_BENCH_MM_ALLOCATOR_H
+#define ARC_BENCH_MM_ALLOCATOR_H
+
+#include <stddef.h>
+
+#define alloc(__size) host_alloc(__size)
+#define calloc(__count, __size) host_calloc(__count, __size)
+#define free(__address) host_free(__address)
+
+/**
+ * Allocate memory, page aligned if size is at least a page as with the
+ * kernel's allocator.
+ * */
+void *host_alloc(size_t size);
+void *host_calloc(size_t count, size_t size);
+void host_free(void *address);
+
+#endif
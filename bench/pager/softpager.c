@@ -0,0 +1,640 @@
+/**
+ * @file softpager.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Pager backend keeping x86-64 style page tables of 4 or 5 levels in ordinary
+ * memory. Entries are laid out as on x86-64, except for the PAT index, which
+ * is kept whole. Frames given out by fly_map come from the allocator, and are
+ * reached through the HHDM like the tables.
+*/
+#include "softpager.h"
+#include "global.h"
+#include "mm/allocator.h"
+
+#include <stdbool.h>
+
+#define SOFT_TABLE_ENTRIES 512
+#define SOFT_PAGE_SIZE 0x1000
+#define SOFT_LEVEL_SIZE(__level) (1ULL << (12 + 9 * ((__level) - 1)))
+#define SOFT_LEVEL_INDEX(__virtual, __level) (((__virtual) >> (12 + 9 * ((__level) - 1))) & (SOFT_TABLE_ENTRIES - 1))
+#define SOFT_ALIGN_DOWN(__value, __size) ((__value) & ~((uintptr_t)(__size) - 1))
+// Highest level whose entries may map a page (1G)
+#define SOFT_PAGE_LEVEL_MAX 3
+
+#define SOFT_PRESENT (1ULL << 0)
+#define SOFT_RW (1ULL << 1)
+#define SOFT_US (1ULL << 2)
+#define SOFT_PAT_SHIFT 3
+#define SOFT_PAT (0b111ULL << SOFT_PAT_SHIFT)
+#define SOFT_LARGE (1ULL << 7)
+// Software bits: the frame is counted with pager_share_frame, and the page is
+// made writable once its copy-on-write is resolved
+#define SOFT_SHARED (1ULL << 9)
+#define SOFT_COW (1ULL << 10)
+#define SOFT_ADDRESS 0x000FFFFFFFFFF000ULL
+#define SOFT_NX (1ULL << 63)
+
+// Parameters of a mapping, shared by every level soft_map_range descends to
+struct soft_map {
+	// Start of the range and where it maps to
+	uintptr_t virtual;
+	uintptr_t physical;
+	uint32_t attributes;
+	// Software bits set in each page entry
+	uint64_t bits;
+	// 1: Map newly allocated frames rather than physical
+	bool fly;
+};
+
+static int soft_levels = 4;
+static size_t soft_demotions = 0;
+static size_t soft_promotions = 0;
+
+static uint64_t soft_table_entry(uint64_t *table) {
+	return ARC_HHDM_TO_PHYS(table) | SOFT_PRESENT | SOFT_RW | SOFT_US;
+}
+
+static uint64_t *soft_table(uint64_t entry) {
+	return (uint64_t *)ARC_PHYS_TO_HHDM(entry & SOFT_ADDRESS);
+}
+
+static uint64_t soft_page_entry(uintptr_t physical, uint32_t attributes, int level) {
+	return (physical & SOFT_ADDRESS) | SOFT_PRESENT
+	       | ((uint64_t)((attributes >> ARC_PAGER_PAT) & 0b111) << SOFT_PAT_SHIFT)
+	       | ((attributes & (1 << ARC_PAGER_RW)) ? SOFT_RW : 0)
+	       | ((attributes & (1 << ARC_PAGER_US)) ? SOFT_US : 0)
+	       | ((attributes & (1 << ARC_PAGER_NX)) ? SOFT_NX : 0)
+	       | (level > 1 ? SOFT_LARGE : 0);
+}
+
+static uint32_t soft_page_attributes(uint64_t entry) {
+	return (((entry & SOFT_PAT) >> SOFT_PAT_SHIFT) << ARC_PAGER_PAT)
+	       | ((entry & SOFT_RW) ? 1 << ARC_PAGER_RW : 0)
+	       | ((entry & SOFT_US) ? 1 << ARC_PAGER_US : 0)
+	       | ((entry & SOFT_NX) ? 1 << ARC_PAGER_NX : 0);
+}
+
+static bool soft_is_page(uint64_t entry, int level) {
+	return level == 1 || (entry & SOFT_LARGE) != 0;
+}
+
+static bool soft_table_empty(uint64_t *table) {
+	for (int i = 0; i < SOFT_TABLE_ENTRIES; i++) {
+		if ((table[i] & SOFT_PRESENT) != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Get the entry mapping virtual, or the empty entry the walk stopped at
+static uint64_t *soft_lookup(void *page_tables, uintptr_t virtual, int *level) {
+	uint64_t *table = page_tables;
+
+	for (int current = soft_levels;; current--) {
+		uint64_t *entry = &table[SOFT_LEVEL_INDEX(virtual, current)];
+		*level = current;
+
+		if ((*entry & SOFT_PRESENT) == 0 || soft_is_page(*entry, current)) {
+			return entry;
+		}
+
+		table = soft_table(*entry);
+	}
+}
+
+// Replace a large page with a table of pages of the next size mapping the
+// same memory. The translations do not change, so nothing is invalidated
+static int soft_split(uint64_t *entry, int level) {
+	uint64_t *table = pager_alloc_table();
+
+	if (table == NULL) {
+		return -1;
+	}
+
+	uint64_t physical = *entry & SOFT_ADDRESS;
+	uint64_t bits = *entry & ~SOFT_ADDRESS;
+
+	if (level - 1 == 1) {
+		bits &= ~SOFT_LARGE;
+	}
+
+	for (int i = 0; i < SOFT_TABLE_ENTRIES; i++) {
+		table[i] = (physical + i * SOFT_LEVEL_SIZE(level - 1)) | bits;
+	}
+
+	*entry = soft_table_entry(table);
+	soft_demotions++;
+
+	return 0;
+}
+
+// Get the table an entry points to, creating it if create is set, or
+// splitting the large page the entry maps
+static uint64_t *soft_descend(uint64_t *entry, int level, bool create) {
+	if ((*entry & SOFT_PRESENT) == 0) {
+		uint64_t *table = create ? pager_alloc_table() : NULL;
+
+		if (table == NULL) {
+			return NULL;
+		}
+
+		*entry = soft_table_entry(table);
+	} else if (soft_is_page(*entry, level) && soft_split(entry, level) != 0) {
+		return NULL;
+	}
+
+	return soft_table(*entry);
+}
+
+// Queue a table and the tables below it to be freed, the pages they map are
+// left alone
+static void soft_free_tables(ARC_PagerBatch *batch, uint64_t *table, int level) {
+	for (int i = 0; level > 1 && i < SOFT_TABLE_ENTRIES; i++) {
+		if ((table[i] & SOFT_PRESENT) != 0 && !soft_is_page(table[i], level)) {
+			soft_free_tables(batch, soft_table(table[i]), level - 1);
+		}
+	}
+
+	pager_batch_free_table(batch, table);
+}
+
+// Drop the shares of an unmapped page, and queue its frames if they came
+// from fly_map and are no longer shared
+static void soft_release_page(ARC_PagerBatch *batch, uint64_t entry, size_t size, bool frames) {
+	uintptr_t physical = entry & SOFT_ADDRESS;
+
+	if (!frames && (entry & SOFT_SHARED) == 0) {
+		return;
+	}
+
+	for (size_t offset = 0; offset < size; offset += SOFT_PAGE_SIZE) {
+		if ((entry & SOFT_SHARED) != 0 && pager_unshare_frame(physical + offset) > 0) {
+			continue;
+		}
+
+		if (frames) {
+			pager_batch_free_frame(batch, (void *)ARC_PHYS_TO_HHDM(physical + offset));
+		}
+	}
+}
+
+static int soft_map_page(ARC_PagerBatch *batch, struct soft_map *map, uint64_t *entry, int level, uintptr_t virtual, uintptr_t physical) {
+	if ((*entry & SOFT_PRESENT) != 0) {
+		if ((map->attributes & (1 << ARC_PAGER_OVW)) == 0) {
+			return -1;
+		}
+
+		if (!soft_is_page(*entry, level)) {
+			soft_free_tables(batch, soft_table(*entry), level - 1);
+		}
+
+		pager_batch_add(batch, virtual, SOFT_LEVEL_SIZE(level));
+	}
+
+	if (map->fly) {
+		void *frame = alloc(SOFT_PAGE_SIZE);
+
+		if (frame == NULL) {
+			return -1;
+		}
+
+		memset(frame, 0, SOFT_PAGE_SIZE);
+		physical = ARC_HHDM_TO_PHYS(frame);
+	}
+
+	*entry = soft_page_entry(physical, map->attributes, level) | map->bits;
+
+	return 0;
+}
+
+static int soft_map_range(ARC_PagerBatch *batch, struct soft_map *map, uint64_t *table, int level, uintptr_t start, uintptr_t end) {
+	uintptr_t size = SOFT_LEVEL_SIZE(level);
+	bool large = !map->fly && (map->attributes & (1 << ARC_PAGER_4K)) == 0 && level <= SOFT_PAGE_LEVEL_MAX;
+	int ret = 0;
+
+	for (uintptr_t address = start; address < end;) {
+		uintptr_t first = SOFT_ALIGN_DOWN(address, size);
+		uintptr_t next = end - first <= size ? end : first + size;
+		uint64_t *entry = &table[SOFT_LEVEL_INDEX(address, level)];
+		uintptr_t physical = map->physical + (address - map->virtual);
+
+		if (level == 1 || (large && address == first && next - first == size && (physical & (size - 1)) == 0)) {
+			ret |= soft_map_page(batch, map, entry, level, first, physical);
+		} else {
+			uint64_t *next_table = soft_descend(entry, level, true);
+			ret |= next_table == NULL ? -1 : soft_map_range(batch, map, next_table, level - 1, address, next);
+		}
+
+		address = next;
+	}
+
+	return ret;
+}
+
+// Unmap a range, along with the tables it leaves empty
+static int soft_unmap_range(ARC_PagerBatch *batch, uint64_t *table, int level, uintptr_t start, uintptr_t end, bool frames) {
+	uintptr_t size = SOFT_LEVEL_SIZE(level);
+	int ret = 0;
+
+	for (uintptr_t address = start; address < end;) {
+		uintptr_t first = SOFT_ALIGN_DOWN(address, size);
+		uintptr_t next = end - first <= size ? end : first + size;
+		uint64_t *entry = &table[SOFT_LEVEL_INDEX(address, level)];
+
+		if ((*entry & SOFT_PRESENT) == 0) {
+			address = next;
+			continue;
+		}
+
+		if (soft_is_page(*entry, level) && address == first && next - first == size) {
+			soft_release_page(batch, *entry, size, frames);
+			*entry = 0;
+			pager_batch_add(batch, first, size);
+			address = next;
+			continue;
+		}
+
+		uint64_t *next_table = soft_descend(entry, level, false);
+
+		if (next_table == NULL) {
+			ret = -1;
+		} else {
+			ret |= soft_unmap_range(batch, next_table, level - 1, address, next, frames);
+
+			if (soft_table_empty(next_table)) {
+				*entry = 0;
+				pager_batch_free_table(batch, next_table);
+			}
+		}
+
+		address = next;
+	}
+
+	return ret;
+}
+
+static int soft_set_attr_range(ARC_PagerBatch *batch, uint64_t *table, int level, uintptr_t start, uintptr_t end, uint32_t attributes) {
+	uintptr_t size = SOFT_LEVEL_SIZE(level);
+	int ret = 0;
+
+	for (uintptr_t address = start; address < end;) {
+		uintptr_t first = SOFT_ALIGN_DOWN(address, size);
+		uintptr_t next = end - first <= size ? end : first + size;
+		uint64_t *entry = &table[SOFT_LEVEL_INDEX(address, level)];
+
+		if ((*entry & SOFT_PRESENT) == 0) {
+			address = next;
+			continue;
+		}
+
+		if (soft_is_page(*entry, level) && address == first && next - first == size) {
+			uint64_t updated = soft_page_entry(*entry & SOFT_ADDRESS, attributes, level) | (*entry & SOFT_SHARED);
+
+			// Shared frames are only ever written through a copy
+			if ((updated & (SOFT_SHARED | SOFT_RW)) == (SOFT_SHARED | SOFT_RW)) {
+				updated = (updated & ~SOFT_RW) | SOFT_COW;
+			}
+
+			if (updated != *entry) {
+				*entry = updated;
+				pager_batch_add(batch, first, size);
+			}
+
+			address = next;
+			continue;
+		}
+
+		uint64_t *next_table = soft_descend(entry, level, false);
+		ret |= next_table == NULL ? -1 : soft_set_attr_range(batch, next_table, level - 1, address, next, attributes);
+
+		address = next;
+	}
+
+	return ret;
+}
+
+// Whether a table maps its whole range contiguously with equal bits, from an
+// address aligned for the page that would replace it
+static bool soft_table_uniform(uint64_t *table, int level) {
+	uint64_t first = table[0];
+
+	if ((first & SOFT_PRESENT) == 0 || !soft_is_page(first, level) || (first & SOFT_ADDRESS & (SOFT_LEVEL_SIZE(level + 1) - 1)) != 0) {
+		return false;
+	}
+
+	for (int i = 1; i < SOFT_TABLE_ENTRIES; i++) {
+		if (table[i] != first + i * SOFT_LEVEL_SIZE(level)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int soft_promote_range(ARC_PagerBatch *batch, uint64_t *table, int level, uintptr_t start, uintptr_t end) {
+	uintptr_t size = SOFT_LEVEL_SIZE(level);
+	int promoted = 0;
+
+	for (uintptr_t address = start; address < end;) {
+		uintptr_t first = SOFT_ALIGN_DOWN(address, size);
+		uintptr_t next = end - first <= size ? end : first + size;
+		uint64_t *entry = &table[SOFT_LEVEL_INDEX(address, level)];
+
+		if ((*entry & SOFT_PRESENT) == 0 || soft_is_page(*entry, level)) {
+			address = next;
+			continue;
+		}
+
+		uint64_t *next_table = soft_table(*entry);
+
+		// Smaller regions first, they may add up to this one
+		if (level > 2) {
+			promoted += soft_promote_range(batch, next_table, level - 1, address, next);
+		}
+
+		if (level <= SOFT_PAGE_LEVEL_MAX && address == first && next - first == size && soft_table_uniform(next_table, level - 1)) {
+			*entry = next_table[0] | SOFT_LARGE;
+			pager_batch_free_table(batch, next_table);
+			pager_batch_add(batch, first, size);
+			soft_promotions++;
+			promoted++;
+		}
+
+		address = next;
+	}
+
+	return promoted;
+}
+
+static void *soft_create() {
+	return pager_alloc_table();
+}
+
+// Frames are left to whoever mapped them, only the tables are freed
+static int soft_destroy(ARC_PagerBatch *batch) {
+	if (batch->page_tables == NULL) {
+		return -1;
+	}
+
+	soft_free_tables(batch, batch->page_tables, soft_levels);
+
+	return 0;
+}
+
+static int soft_map(ARC_PagerBatch *batch, uintptr_t virtual, uintptr_t physical, size_t size, uint32_t attributes) {
+	struct soft_map map = { .virtual = virtual, .physical = physical, .attributes = attributes };
+	int ret = soft_map_range(batch, &map, batch->page_tables, soft_levels, virtual, virtual + size);
+
+	if ((attributes & (1 << ARC_PAGER_PROMOTE)) != 0 && (attributes & (1 << ARC_PAGER_4K)) == 0) {
+		uintptr_t region = SOFT_LEVEL_SIZE(SOFT_PAGE_LEVEL_MAX);
+		uintptr_t start = SOFT_ALIGN_DOWN(virtual, region);
+		soft_promote_range(batch, batch->page_tables, soft_levels, start, SOFT_ALIGN_DOWN(virtual + size + region - 1, region));
+	}
+
+	return ret == 0 ? 0 : -1;
+}
+
+static int soft_unmap(ARC_PagerBatch *batch, uintptr_t virtual, size_t size, void **physical) {
+	if (physical != NULL) {
+		int level = 0;
+		uint64_t *entry = soft_lookup(batch->page_tables, virtual, &level);
+
+		*physical = NULL;
+
+		if ((*entry & SOFT_PRESENT) != 0) {
+			*physical = (void *)((*entry & SOFT_ADDRESS) + (virtual & (SOFT_LEVEL_SIZE(level) - 1)));
+		}
+	}
+
+	return soft_unmap_range(batch, batch->page_tables, soft_levels, virtual, virtual + size, false) == 0 ? 0 : -1;
+}
+
+static int soft_fly_map(ARC_PagerBatch *batch, uintptr_t virtual, size_t size, uint32_t attributes) {
+	struct soft_map map = { .virtual = virtual, .attributes = attributes, .fly = true };
+
+	return soft_map_range(batch, &map, batch->page_tables, soft_levels, virtual, virtual + size) == 0 ? 0 : -1;
+}
+
+static int soft_fly_unmap(ARC_PagerBatch *batch, uintptr_t virtual, size_t size) {
+	return soft_unmap_range(batch, batch->page_tables, soft_levels, virtual, virtual + size, true) == 0 ? 0 : -1;
+}
+
+static int soft_set_attr(ARC_PagerBatch *batch, uintptr_t virtual, size_t size, uint32_t attributes) {
+	return soft_set_attr_range(batch, batch->page_tables, soft_levels, virtual, virtual + size, attributes) == 0 ? 0 : -1;
+}
+
+static int soft_promote(ARC_PagerBatch *batch, uintptr_t virtual, size_t size) {
+	return soft_promote_range(batch, batch->page_tables, soft_levels, virtual, virtual + size);
+}
+
+static int soft_clone(ARC_PagerBatch *dest, ARC_PagerBatch *src, uintptr_t virt_src, uintptr_t virt_dest, size_t size, uint32_t flags) {
+	bool cow = (flags & (1 << ARC_PAGER_CLONE_COW)) != 0;
+	uintptr_t end = virt_src + size;
+	int ret = 0;
+
+	for (uintptr_t address = virt_src; address < end;) {
+		int level = 0;
+		uint64_t *entry = soft_lookup(src->page_tables, address, &level);
+		uintptr_t page_size = SOFT_LEVEL_SIZE(level);
+		uintptr_t first = SOFT_ALIGN_DOWN(address, page_size);
+		uintptr_t next = end - first <= page_size ? end : first + page_size;
+
+		if ((*entry & SOFT_PRESENT) == 0) {
+			address = next;
+			continue;
+		}
+
+		uint64_t bits = 0;
+
+		if (cow) {
+			// Only the part within the range is made copy-on-write
+			if (level > 1 && (address != first || next - first != page_size)) {
+				if (soft_split(entry, level) != 0) {
+					return -1;
+				}
+
+				continue;
+			}
+
+			for (uintptr_t offset = 0; offset < page_size; offset += SOFT_PAGE_SIZE) {
+				if (pager_share_frame((*entry & SOFT_ADDRESS) + offset) != 0) {
+					return -1;
+				}
+			}
+
+			uint64_t updated = *entry | SOFT_SHARED;
+
+			if ((updated & SOFT_RW) != 0) {
+				updated = (updated & ~SOFT_RW) | SOFT_COW;
+				pager_batch_add(src, first, page_size);
+			}
+
+			*entry = updated;
+			bits = updated & (SOFT_SHARED | SOFT_COW);
+		}
+
+		struct soft_map map = {
+		        .virtual = virt_dest + (address - virt_src),
+		        .physical = (*entry & SOFT_ADDRESS) + (address - first),
+		        .attributes = soft_page_attributes(*entry),
+		        .bits = bits,
+		};
+
+		ret |= soft_map_range(dest, &map, dest->page_tables, soft_levels, map.virtual, virt_dest + (next - virt_src));
+		address = next;
+	}
+
+	return ret == 0 ? 0 : -1;
+}
+
+static int soft_resolve_cow(ARC_PagerBatch *batch, uintptr_t virtual) {
+	int level = 0;
+	uint64_t *entry = soft_lookup(batch->page_tables, virtual, &level);
+
+	if ((*entry & SOFT_PRESENT) == 0 || (*entry & SOFT_COW) == 0) {
+		return 1;
+	}
+
+	// Frames are copied one at a time
+	for (; level > 1; level--) {
+		if (soft_split(entry, level) != 0) {
+			return -1;
+		}
+
+		entry = &soft_table(*entry)[SOFT_LEVEL_INDEX(virtual, level - 1)];
+	}
+
+	uintptr_t physical = *entry & SOFT_ADDRESS;
+	uint64_t bits = (*entry & ~(SOFT_ADDRESS | SOFT_SHARED | SOFT_COW)) | SOFT_RW;
+
+	if (pager_get_frame_shares(physical) <= 1) {
+		// The last mapping keeps the frame
+		*entry = physical | bits;
+	} else {
+		void *copy = alloc(SOFT_PAGE_SIZE);
+
+		if (copy == NULL) {
+			return -1;
+		}
+
+		memcpy(copy, (void *)ARC_PHYS_TO_HHDM(physical), SOFT_PAGE_SIZE);
+		*entry = ARC_HHDM_TO_PHYS(copy) | bits;
+
+		// Another mapping may have dropped its share meanwhile
+		if (pager_unshare_frame(physical) == 0) {
+			pager_batch_free_frame(batch, (void *)ARC_PHYS_TO_HHDM(physical));
+		}
+	}
+
+	pager_batch_add(batch, SOFT_ALIGN_DOWN(virtual, SOFT_PAGE_SIZE), SOFT_PAGE_SIZE);
+
+	return 0;
+}
+
+static int soft_translate(void *page_tables, uintptr_t virtual, ARC_PagerTranslation *translation) {
+	int level = 0;
+	uint64_t *entry = soft_lookup(page_tables, virtual, &level);
+	size_t size = SOFT_LEVEL_SIZE(level);
+
+	translation->page_size = size;
+
+	if ((*entry & SOFT_PRESENT) == 0) {
+		return -1;
+	}
+
+	translation->physical = (*entry & SOFT_ADDRESS) + (virtual & (size - 1));
+	translation->attributes = soft_page_attributes(*entry);
+
+	return 0;
+}
+
+static void soft_count_pages(uint64_t *table, int level, ARC_PagerStats *stats) {
+	for (int i = 0; i < SOFT_TABLE_ENTRIES; i++) {
+		if ((table[i] & SOFT_PRESENT) == 0) {
+			continue;
+		}
+
+		if (!soft_is_page(table[i], level)) {
+			soft_count_pages(soft_table(table[i]), level - 1, stats);
+		} else if (level == 1) {
+			stats->pages_4k++;
+		} else if (level == 2) {
+			stats->pages_2m++;
+		} else {
+			stats->pages_1g++;
+		}
+	}
+}
+
+// Demotions and promotions are counted across all tables
+static int soft_get_stats(void *page_tables, ARC_PagerStats *stats) {
+	*stats = (ARC_PagerStats){ .demotions = soft_demotions, .promotions = soft_promotions };
+	soft_count_pages(page_tables, soft_levels, stats);
+
+	return 0;
+}
+
+// There is no TLB to invalidate
+static void soft_flush_local(int kind, uintptr_t start, uintptr_t end) {
+	(void)kind;
+	(void)start;
+	(void)end;
+}
+
+static void soft_load_local(void *page_tables, uint32_t tag, bool flush) {
+	(void)page_tables;
+	(void)tag;
+	(void)flush;
+}
+
+static ARC_PagerBackend soft_backend = {
+	.create = soft_create,
+	.destroy = soft_destroy,
+	.map = soft_map,
+	.unmap = soft_unmap,
+	.fly_map = soft_fly_map,
+	.fly_unmap = soft_fly_unmap,
+	.set_attr = soft_set_attr,
+	.promote = soft_promote,
+	.clone = soft_clone,
+	.resolve_cow = soft_resolve_cow,
+	.translate = soft_translate,
+	.get_stats = soft_get_stats,
+	.flush_local = soft_flush_local,
+	.load_local = soft_load_local,
+};
+
+ARC_PagerBackend *softpager_get_backend(int levels) {
+	if (levels != 4 && levels != 5) {
+		ARC_DEBUG(ERR, "Cannot simulate %d level page tables\n", levels);
+		return NULL;
+	}
+
+	soft_levels = levels;
+	soft_backend.levels = levels;
+
+	return &soft_backend;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file softpager.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Software pager backend, simulating x86-64 style page tables in ordinary
+ * memory so that the pager frontend can be exercised on a host.
+*/
+#ifndef ARC_BENCH_SOFTPAGER_H
+#define ARC_BENCH_SOFTPAGER_H
+
+#include "arch/pager.h"
+
+/**
+ * Get the software backend, simulating page tables of 4 or 5 levels.
+ *
+ * Pages of 4K, 2M and 1G are supported as on x86-64. The tables are only
+ * walked by the backend itself, nothing is handed to an MMU. The number of
+ * levels applies to every set of tables, so it may only change while none
+ * exist.
+ *
+ * @return the backend to install with pager_set_backend, NULL if levels is
+ * not supported.
+ * */
+ARC_PagerBackend *softpager_get_backend(int levels);
+
+#endif
@@ -25,12 +25,20 @@
  * @DESCRIPTION
 */
 #include "arch/acpi/acpi.h"
+#include "arch/hpet.h"
+#include "arch/numa.h"
+#include "arch/pager.h"
+#include "arch/power.h"
+#include "arch/smp.h"
+#include "arch/snapshot.h"
 #include "drivers/resource.h"
 #include "fs/vfs.h"
 #include "global.h"
 #include "lib/hash.h"
+#include "lib/spinlock.h"
 #include "lib/util.h"
 #include "mm/allocator.h"
+#include "uacpi/context.h"
 #include "uacpi/event.h"
 #include "uacpi/namespace.h"
 #include "uacpi/resources.h"
@@ -38,6 +46,52 @@
 #include "uacpi/uacpi.h"
 #include "uacpi/utilities.h"
 
+#define ACPI_MAX_PCI_ROOTS 32
+
+struct acpi_pci_root {
+	uint16_t segment;
+	uint8_t bus;
+	uint32_t node;
+};
+
+static struct acpi_pci_root acpi_pci_roots[ACPI_MAX_PCI_ROOTS] = { 0 };
+static int acpi_pci_root_count = 0;
+
+static const uacpi_char *const acpi_pci_root_ids[] = {
+	"PNP0A03",
+	"PNP0A08",
+	NULL
+};
+
+#define ACPI_NODE_CACHE_BUCKETS 256
+// Longest absolute path the cache keeps, including the terminator
+#define ACPI_NODE_PATH_MAX 256
+
+// Entries remember where a device is rather than its node, which holds no
+// reference and so cannot dangle. The node is found again from the path
+struct acpi_node_entry {
+	struct acpi_node_entry *next;
+	uint64_t hash;
+	// The _HID followed by the _UID (if any), each with its terminator
+	char *key;
+	size_t key_size;
+	// Absolute path of the device, with its terminator
+	char *path;
+	size_t path_size;
+};
+
+struct acpi_node_cache {
+	// Value of acpi_node_cache_generation the cache was built at
+	uint64_t generation;
+	struct acpi_node_entry *by_id[ACPI_NODE_CACHE_BUCKETS];
+};
+
+static struct acpi_node_cache *acpi_node_cache = NULL;
+// Advanced when tables are loaded or nodes are removed, the cache is rebuilt
+// on next use once it falls behind
+static uint64_t acpi_node_cache_generation = 0;
+static ARC_Spinlock acpi_node_cache_lock = { 0 };
+
 static int acpi_clean_up_args(struct ARC_ACPIDevInfo *args) {
 	if (args == NULL) {
 		return -1;
@@ -154,18 +208,441 @@ uacpi_resource_iteration_decision res_ls_callback(void *user, uacpi_resource *re
 	return UACPI_RESOURCE_ITERATION_CONTINUE;
 }
 
+// A device inherits the proximity of the closest ancestor with a _PXM
+static uint32_t acpi_get_node(uacpi_namespace_node *node) {
+	for (; node != NULL; node = uacpi_namespace_node_parent(node)) {
+		uint64_t domain = 0;
+
+		if (uacpi_eval_simple_integer(node, "_PXM", &domain) == UACPI_STATUS_OK) {
+			return numa_get_domain_node(domain);
+		}
+	}
+
+	return ARC_NUMA_NO_NODE;
+}
+
+static void acpi_add_pci_root(uacpi_namespace_node *node, uint32_t numa_node) {
+	if (acpi_pci_root_count >= ACPI_MAX_PCI_ROOTS) {
+		ARC_DEBUG(WARN, "Too many PCI host bridges\n");
+		return;
+	}
+
+	// Both default to 0 when absent
+	uint64_t segment = 0;
+	uint64_t bus = 0;
+	uacpi_eval_simple_integer(node, "_SEG", &segment);
+	uacpi_eval_simple_integer(node, "_BBN", &bus);
+
+	struct acpi_pci_root *root = &acpi_pci_roots[acpi_pci_root_count++];
+	root->segment = segment;
+	root->bus = bus;
+	root->node = numa_node;
+
+	ARC_SnapshotPCIRoot record = { .segment = segment, .bus = bus, .node = numa_node };
+	snapshot_record(ARC_SNAPSHOT_PCI_ROOT, &record);
+
+	ARC_DEBUG(INFO, "PCI host bridge %04X:%02X on node %d\n", root->segment, root->bus, numa_node);
+}
+
+uint32_t acpi_get_pci_root_node(uint16_t segment, uint8_t bus) {
+	for (int i = 0; i < acpi_pci_root_count; i++) {
+		if (acpi_pci_roots[i].segment == segment && acpi_pci_roots[i].bus == bus) {
+			return acpi_pci_roots[i].node;
+		}
+	}
+
+	return ARC_NUMA_NO_NODE;
+}
+
+static uint64_t acpi_hash_id(const char *hid, size_t hid_size, const char *uid, size_t uid_size) {
+	uint64_t hash = hash_fnv1a((uint8_t *)hid, hid_size);
+
+	if (uid != NULL) {
+		hash ^= hash_fnv1a((uint8_t *)uid, uid_size) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+	}
+
+	return hash;
+}
+
+static int acpi_cache_insert(struct acpi_node_entry **buckets, uint64_t hash, const char *key, size_t key_size,
+			     const char *suffix, size_t suffix_size, const char *path) {
+	size_t path_size = strlen(path) + 1;
+
+	if (path_size > ACPI_NODE_PATH_MAX) {
+		return -1;
+	}
+
+	struct acpi_node_entry *entry = alloc(sizeof(*entry));
+
+	if (entry == NULL) {
+		return -1;
+	}
+
+	entry->key = alloc(key_size + suffix_size + path_size);
+
+	if (entry->key == NULL) {
+		free(entry);
+		return -1;
+	}
+
+	memcpy(entry->key, key, key_size);
+	if (suffix_size > 0) {
+		memcpy(entry->key + key_size, suffix, suffix_size);
+	}
+
+	entry->hash = hash;
+	entry->key_size = key_size + suffix_size;
+	entry->path = entry->key + entry->key_size;
+	entry->path_size = path_size;
+	memcpy(entry->path, path, path_size);
+
+	entry->next = buckets[hash % ACPI_NODE_CACHE_BUCKETS];
+	buckets[hash % ACPI_NODE_CACHE_BUCKETS] = entry;
+
+	return 0;
+}
+
+static bool acpi_cache_matches(struct acpi_node_entry *entry, uint64_t hash, const char *key, size_t key_size,
+			       const char *suffix, size_t suffix_size) {
+	return entry->hash == hash && entry->key_size == key_size + suffix_size
+	       && memcmp(entry->key, key, key_size) == 0
+	       && (suffix_size == 0 || memcmp(entry->key + key_size, suffix, suffix_size) == 0);
+}
+
+static void acpi_cache_node(struct acpi_node_cache *cache, uacpi_namespace_node *node, uacpi_id_string *hid, uacpi_id_string *uid) {
+	if (cache == NULL || hid == NULL) {
+		return;
+	}
+
+	const uacpi_char *path = uacpi_namespace_node_generate_absolute_path(node);
+
+	if (path == NULL) {
+		return;
+	}
+
+	const char *uid_value = uid != NULL ? uid->value : NULL;
+	size_t uid_size = uid != NULL ? uid->size : 0;
+	uint64_t hash = acpi_hash_id(hid->value, hid->size, uid_value, uid_size);
+	acpi_cache_insert(cache->by_id, hash, hid->value, hid->size, uid_value, uid_size, path);
+
+	uacpi_free_absolute_path(path);
+}
+
+static void acpi_free_node_entries(struct acpi_node_entry *entry) {
+	while (entry != NULL) {
+		struct acpi_node_entry *next = entry->next;
+		free(entry->key);
+		free(entry);
+		entry = next;
+	}
+}
+
+static void acpi_free_node_cache(struct acpi_node_cache *cache) {
+	if (cache == NULL) {
+		return;
+	}
+
+	for (int i = 0; i < ACPI_NODE_CACHE_BUCKETS; i++) {
+		acpi_free_node_entries(cache->by_id[i]);
+	}
+
+	free(cache);
+}
+
+static uacpi_ns_iteration_decision acpi_cache_callback(void *user, uacpi_namespace_node *node) {
+	uacpi_object_type type = UACPI_OBJECT_UNINITIALIZED;
+
+	if (uacpi_namespace_node_type(node, &type) != UACPI_STATUS_OK || type != UACPI_OBJECT_DEVICE) {
+		return UACPI_NS_ITERATION_DECISION_CONTINUE;
+	}
+
+	uacpi_id_string *uid = NULL;
+	uacpi_id_string *hid = NULL;
+
+	uacpi_eval_uid(node, &uid);
+	uacpi_eval_hid(node, &hid);
+
+	acpi_cache_node(user, node, hid, uid);
+
+	uacpi_free_id_string(uid);
+	uacpi_free_id_string(hid);
+
+	return UACPI_NS_ITERATION_DECISION_CONTINUE;
+}
+
+static struct acpi_node_cache *acpi_create_node_cache() {
+	struct acpi_node_cache *cache = calloc(1, sizeof(*cache));
+
+	if (cache == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate namespace cache\n");
+		return NULL;
+	}
+
+	cache->generation = __atomic_load_n(&acpi_node_cache_generation, __ATOMIC_ACQUIRE);
+
+	return cache;
+}
+
+// Swap in a new cache unless a newer one is already in place
+static void acpi_install_node_cache(struct acpi_node_cache *cache) {
+	spinlock_lock(&acpi_node_cache_lock);
+	struct acpi_node_cache *old = acpi_node_cache;
+
+	if (old == NULL || old->generation <= cache->generation) {
+		acpi_node_cache = cache;
+	} else {
+		old = cache;
+	}
+
+	spinlock_unlock(&acpi_node_cache_lock);
+
+	acpi_free_node_cache(old);
+}
+
+// Rebuild the cache if it was invalidated, without holding the lock while
+// evaluating _HID and _UID
+static void acpi_refresh_node_cache() {
+	uint64_t generation = __atomic_load_n(&acpi_node_cache_generation, __ATOMIC_ACQUIRE);
+
+	spinlock_lock(&acpi_node_cache_lock);
+	bool current = acpi_node_cache != NULL && acpi_node_cache->generation == generation;
+	spinlock_unlock(&acpi_node_cache_lock);
+
+	if (current) {
+		return;
+	}
+
+	struct acpi_node_cache *cache = acpi_create_node_cache();
+
+	if (cache == NULL) {
+		return;
+	}
+
+	uacpi_namespace_for_each_node_depth_first(uacpi_namespace_root(), acpi_cache_callback, cache);
+	acpi_install_node_cache(cache);
+}
+
+void acpi_invalidate_node_cache() {
+	__atomic_add_fetch(&acpi_node_cache_generation, 1, __ATOMIC_RELEASE);
+
+	spinlock_lock(&acpi_node_cache_lock);
+	struct acpi_node_cache *old = acpi_node_cache;
+	acpi_node_cache = NULL;
+	spinlock_unlock(&acpi_node_cache_lock);
+
+	acpi_free_node_cache(old);
+}
+
+static uacpi_table_installation_disposition acpi_table_install_handler(struct acpi_sdt_hdr *header, uacpi_u64 *override) {
+	(void)header;
+	(void)override;
+
+	acpi_invalidate_node_cache();
+
+	return UACPI_TABLE_INSTALLATION_DISPOSITON_ALLOW;
+}
+
+uacpi_namespace_node *acpi_find_node(const char *path) {
+	if (path == NULL) {
+		return NULL;
+	}
+
+	uacpi_namespace_node *node = NULL;
+
+	if (uacpi_namespace_node_find(NULL, path, &node) != UACPI_STATUS_OK) {
+		return NULL;
+	}
+
+	return node;
+}
+
+// Copy the path of the device with an ID out of the cache
+static bool acpi_lookup_path_by_id(uint64_t hash, const char *hid, size_t hid_size, const char *uid, size_t uid_size, char *path) {
+	bool found = false;
+
+	spinlock_lock(&acpi_node_cache_lock);
+
+	if (acpi_node_cache != NULL) {
+		struct acpi_node_entry *entry = acpi_node_cache->by_id[hash % ACPI_NODE_CACHE_BUCKETS];
+
+		for (; entry != NULL; entry = entry->next) {
+			if (acpi_cache_matches(entry, hash, hid, hid_size, uid, uid_size)) {
+				memcpy(path, entry->path, entry->path_size);
+				found = true;
+				break;
+			}
+		}
+	}
+
+	spinlock_unlock(&acpi_node_cache_lock);
+
+	return found;
+}
+
+uacpi_namespace_node *acpi_find_node_by_id(const char *hid, const char *uid) {
+	if (hid == NULL) {
+		return NULL;
+	}
+
+	acpi_refresh_node_cache();
+
+	// Sizes of ID strings include the terminator
+	size_t hid_size = strlen(hid) + 1;
+	size_t uid_size = uid != NULL ? strlen(uid) + 1 : 0;
+	uint64_t hash = acpi_hash_id(hid, hid_size, uid, uid_size);
+	char path[ACPI_NODE_PATH_MAX];
+
+	if (!acpi_lookup_path_by_id(hash, hid, hid_size, uid, uid_size, path)) {
+		return NULL;
+	}
+
+	uacpi_namespace_node *node = acpi_find_node(path);
+
+	if (node == NULL) {
+		// Removed from the namespace (i.e. by an AML Unload), which nothing
+		// reports, so the rest of the cache is as suspect
+		acpi_invalidate_node_cache();
+		acpi_refresh_node_cache();
+
+		if (acpi_lookup_path_by_id(hash, hid, hid_size, uid, uid_size, path)) {
+			node = acpi_find_node(path);
+		}
+	}
+
+	return node;
+}
+
+static void acpi_snapshot_device(uint64_t hash, struct ARC_ACPIDevInfo *info) {
+	ARC_SnapshotACPIDevice device = { .hash = hash, .node = info->numa_node };
+
+	for (ARC_ACPIDevIO *io = info->io; io != NULL; io = io->next) {
+		ARC_SnapshotACPIIO record = {
+		        .base = io->base, .length = io->length, .align = io->align, .decode_type = io->decode_type,
+		};
+
+		if (snapshot_record(ARC_SNAPSHOT_ACPI_IO, &record) == 0) {
+			device.io_count++;
+		}
+	}
+
+	for (ARC_ACPIDevIRQ *irq = info->irq; irq != NULL; irq = irq->next) {
+		ARC_SnapshotACPIIRQ record = {
+		        .polarity = irq->polarity, .sharing = irq->sharing, .triggering = irq->triggering,
+		        .wake_capability = irq->wake_capability, .length_kind = irq->length_kind,
+		};
+
+		record.irq_count = irq->irq_count < ARC_SNAPSHOT_MAX_IRQS ? irq->irq_count : ARC_SNAPSHOT_MAX_IRQS;
+		memcpy(record.irqs, irq->irq_list, record.irq_count);
+
+		if (snapshot_record(ARC_SNAPSHOT_ACPI_IRQ, &record) == 0) {
+			device.irq_count++;
+		}
+	}
+
+	snapshot_record(ARC_SNAPSHOT_ACPI_DEVICE, &device);
+}
+
+// Rebuild the device information found by ls_callback from a snapshot
+static int acpi_replay_snapshot() {
+	uint32_t root_count = 0;
+	uint32_t device_count = 0;
+	uint32_t io_count = 0;
+	uint32_t irq_count = 0;
+	ARC_SnapshotPCIRoot *roots = snapshot_get(ARC_SNAPSHOT_PCI_ROOT, &root_count);
+	ARC_SnapshotACPIDevice *devices = snapshot_get(ARC_SNAPSHOT_ACPI_DEVICE, &device_count);
+	ARC_SnapshotACPIIO *ios = snapshot_get(ARC_SNAPSHOT_ACPI_IO, &io_count);
+	ARC_SnapshotACPIIRQ *irqs = snapshot_get(ARC_SNAPSHOT_ACPI_IRQ, &irq_count);
+
+	if (roots == NULL || devices == NULL || ios == NULL || irqs == NULL) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < root_count && acpi_pci_root_count < ACPI_MAX_PCI_ROOTS; i++) {
+		struct acpi_pci_root *root = &acpi_pci_roots[acpi_pci_root_count++];
+		root->segment = roots[i].segment;
+		root->bus = roots[i].bus;
+		root->node = roots[i].node;
+	}
+
+	uint32_t next_io = 0;
+	uint32_t next_irq = 0;
+
+	for (uint32_t i = 0; i < device_count; i++) {
+		ARC_SnapshotACPIDevice *device = &devices[i];
+		struct ARC_ACPIDevInfo info = { .numa_node = device->node };
+
+		if (next_io + device->io_count > io_count || next_irq + device->irq_count > irq_count) {
+			ARC_DEBUG(ERR, "Snapshot device %d has resources out of bounds\n", i);
+			return -1;
+		}
+
+		// Records were taken head first, walk them backwards to keep list order
+		for (uint32_t j = device->io_count; j > 0; j--) {
+			ARC_SnapshotACPIIO *record = &ios[next_io + j - 1];
+			ARC_ACPIDevIO *io = alloc(sizeof(*io));
+
+			if (io == NULL) {
+				continue;
+			}
+
+			io->base = record->base;
+			io->length = record->length;
+			io->align = record->align;
+			io->decode_type = record->decode_type;
+			io->next = info.io;
+			info.io = io;
+		}
+
+		for (uint32_t j = device->irq_count; j > 0; j--) {
+			ARC_SnapshotACPIIRQ *record = &irqs[next_irq + j - 1];
+			ARC_ACPIDevIRQ *irq = alloc(sizeof(*irq));
+
+			if (irq == NULL) {
+				continue;
+			}
+
+			irq->irq_list = record->irqs;
+			irq->irq_count = record->irq_count;
+			irq->polarity = record->polarity;
+			irq->sharing = record->sharing;
+			irq->triggering = record->triggering;
+			irq->wake_capability = record->wake_capability;
+			irq->length_kind = record->length_kind;
+			irq->next = info.irq;
+			info.irq = irq;
+		}
+
+		next_io += device->io_count;
+		next_irq += device->irq_count;
+
+		init_acpi_resource(device->hash, (void *)&info);
+		acpi_clean_up_args(&info);
+	}
+
+	return 0;
+}
+
 uacpi_ns_iteration_decision ls_callback(void *user, uacpi_namespace_node *node) {
-	(void)user;
-	
+	if (uacpi_device_matches_pnp_id(node, acpi_pci_root_ids)) {
+		acpi_add_pci_root(node, acpi_get_node(node));
+	}
+
+	uacpi_object_type type = UACPI_OBJECT_UNINITIALIZED;
+	uacpi_id_string *uid = NULL;
+	uacpi_id_string *hid = NULL;
+
+	if (uacpi_namespace_node_type(node, &type) == UACPI_STATUS_OK && type == UACPI_OBJECT_DEVICE) {
+		uacpi_eval_uid(node, &uid);
+		uacpi_eval_hid(node, &hid);
+		acpi_cache_node(user, node, hid, uid);
+	}
+
 	struct uacpi_resources *out_resources = NULL;
 
 	if (uacpi_get_current_resources(node, &out_resources) == UACPI_STATUS_OK) {
-		uacpi_id_string *uid = NULL;
-		uacpi_id_string *hid = NULL;
 		uint64_t hash = 0;
 
-		uacpi_eval_uid(node, &uid);
-		if (uacpi_eval_hid(node, &hid) == UACPI_STATUS_OK) {
+		if (hid != NULL) {
 			hash = hash_fnv1a((uint8_t *)hid->value, hid->size);
 		}
 
@@ -174,33 +651,77 @@ uacpi_ns_iteration_decision ls_callback(void *user, uacpi_namespace_node *node)
 						              (hid != NULL ? hid->size : 0), (hid != NULL ? hid->value : 0),
 							      hash);
 							
-		struct ARC_ACPIDevInfo info = { 0 };
+		struct ARC_ACPIDevInfo info = { .numa_node = acpi_get_node(node) };
 		uacpi_for_each_resource(out_resources, res_ls_callback, (void *)&info);
 
+		acpi_snapshot_device(hash, &info);
 		init_acpi_resource(hash, (void *)&info);
 		acpi_clean_up_args(&info);
 	}
 
+	uacpi_free_id_string(uid);
+	uacpi_free_id_string(hid);
+
 	return UACPI_NS_ITERATION_DECISION_CONTINUE;
 }
 
 int init_acpi() {
+	uacpi_context_set_log_level(ARC_ACPI_LOG_LEVEL);
+	init_static_spinlock(&acpi_node_cache_lock);
+	uacpi_set_table_installation_handler(acpi_table_install_handler);
+
 	if (uacpi_initialize(0) != UACPI_STATUS_OK) {
 		ARC_DEBUG(ERR, "Failed to initialize uACPi\n");
+		acpi_flush_log();
 		return -1;
 	}
 
+	if (init_numa() != 0) {
+		ARC_DEBUG(ERR, "Failed to initialize NUMA topology\n");
+	}
+
+	if (init_smp_topology() != 0) {
+		ARC_DEBUG(ERR, "Failed to initialize processor topology\n");
+	}
+
+	// AML stalls and sleeps against the HPET, without one they fall back
+	// to the PM timer
+	init_hpet();
+
 	if (uacpi_namespace_load() != UACPI_STATUS_OK) {
 		ARC_DEBUG(ERR, "Failed to load ACPI namespace\n");
 	}
 
+	if (init_power() != 0) {
+		ARC_DEBUG(ERR, "Failed to discover processor power states\n");
+	}
+
 	if (uacpi_finalize_gpe_initialization() != UACPI_STATUS_OK) {
 		ARC_DEBUG(ERR, "Failed to finalize GPE\n");
 	}
 
 	ARC_DEBUG(INFO, "Initialized uACPI\n");
 
-	uacpi_namespace_for_each_node_depth_first(uacpi_namespace_root(), ls_callback, NULL);
+	// With a snapshot the namespace is only walked once a node is looked up
+	if (acpi_replay_snapshot() != 0) {
+		snapshot_discard(ARC_SNAPSHOT_PCI_ROOT);
+		snapshot_discard(ARC_SNAPSHOT_ACPI_DEVICE);
+		snapshot_discard(ARC_SNAPSHOT_ACPI_IO);
+		snapshot_discard(ARC_SNAPSHOT_ACPI_IRQ);
+		// The scan finds the host bridges a failed replay may have added
+		acpi_pci_root_count = 0;
+
+		struct acpi_node_cache *cache = acpi_create_node_cache();
+		uacpi_namespace_for_each_node_depth_first(uacpi_namespace_root(), ls_callback, cache);
+
+		if (cache != NULL) {
+			acpi_install_node_cache(cache);
+		}
+	}
+
+	// Nothing drains the log before the thread running acpi_handle_events
+	// is started
+	acpi_flush_log();
 
         return 0;
 }
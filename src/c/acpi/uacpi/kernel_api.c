@@ -1,20 +1,193 @@
+#include "arch/acpi/acpi.h"
+#include "arch/acpi/table.h"
+#include "arch/hpet.h"
+#include "arch/interrupt.h"
 #include "arch/io/port.h"
 #include "arch/pager.h"
 #include "arch/pci.h"
+#include "arch/smp.h"
 #include "global.h"
-#include "lib/mutex.h"
 #include "lib/spinlock.h"
 #include "lib/util.h"
 #include "mm/allocator.h"
 #include "mp/scheduler.h"
 #include "uacpi/kernel_api.h"
 #include "uacpi/status.h"
+#include "uacpi/tables.h"
+
+// Number of relax iterations between checks of the owner's state (and the
+// deadline) while waiting on a contended mutex
+#define KERNEL_MUTEX_SPIN_BATCH 64
+
+// Values of the timeout argument to uacpi_kernel_acquire_mutex with special
+// meaning
+#define KERNEL_MUTEX_TRYLOCK 0x0000
+#define KERNEL_MUTEX_INFINITE 0xFFFF
+
+// Size of the SystemIO address space
+#define KERNEL_IO_SPACE_SIZE 0x10000
 
 struct kernel_io_handle {
+	uint16_t base;
+	uint32_t len;
+};
+
+struct kernel_mutex {
+	// Thread ID of the owner + 1, 0 if the mutex is free, waiters park on it
+	uint64_t owner;
+	// Threads parked or about to park on owner
+	uint32_t waiters;
+	// Processor the owner acquired the mutex on, NULL if the mutex is free
+	ARC_ProcessorDescriptor *owner_proc;
+	// Only modified by the owner
+	uint64_t acquisitions;
+	ARC_ACPIMutexStats stats;
+};
+
+static ARC_ACPIMutexStats kernel_mutex_totals = { 0 };
+
+#define KERNEL_PM_TIMER_HZ 3579545
+// Time credited to each read of the clock when there is no timer at all, so
+// that deadlines still pass
+#define KERNEL_CLOCK_POLL_NS 1000
+
+// I/O port of the ACPI PM timer, 0 if unknown, -1 if there is none
+static int32_t kernel_pm_timer_port = 0;
+static uint32_t kernel_pm_timer_mask = 0;
+// Last read of the PM timer, extended to 64 bits
+static uint64_t kernel_pm_timer_last = 0;
+static uint64_t kernel_clock_estimate = 0;
+
+#define KERNEL_MAP_PAGE_SIZE 0x1000
+// Number of unreferenced mappings kept around for reuse before the least
+// recently used is torn down
+#define KERNEL_MAP_IDLE_MAX 16
+
+// How a range came to be mapped, and so how its mapping is undone
+enum {
+	// Was already mapped (i.e. RAM in the HHDM), left alone
+	KERNEL_MAP_BORROWED,
+	// Mapped uncached by the cache, unmapped once torn down
+	KERNEL_MAP_OWNED,
+};
+
+// A page aligned, physically contiguous range mapped at its HHDM address.
+// Ranges in the list are disjoint and sorted by base. A map request takes a
+// reference on every range it overlaps, creating ranges to fill any gaps
+struct kernel_mapping {
+	struct kernel_mapping *next;
 	uint64_t base;
-	size_t len;
+	uint64_t end;
+	uint64_t last_use;
+	uint32_t refs;
+	// KERNEL_MAP_*
+	int state;
+};
+
+static struct kernel_mapping *kernel_mappings = NULL;
+static uint64_t kernel_mappings_clock = 0;
+static uint32_t kernel_mappings_idle = 0;
+static bool kernel_mappings_lock = false;
+
+// Objects up to the largest size class are carved out of chunks of this size,
+// anything larger goes to the general allocator
+#define KERNEL_POOL_CHUNK_SIZE 0x10000
+#define KERNEL_POOL_ALIGN 16
+// Index of the pseudo-class for allocations larger than the largest class
+#define KERNEL_POOL_LARGE ARC_ACPI_POOL_CLASSES
+
+#ifndef UACPI_SIZED_FREES
+// Without sized frees the class of an object is recorded in front of it
+#define KERNEL_POOL_HEADER KERNEL_POOL_ALIGN
+#else
+#define KERNEL_POOL_HEADER 0
+#endif
+
+static const uint32_t kernel_pool_sizes[ARC_ACPI_POOL_CLASSES] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 2048
+};
+
+struct kernel_pool_chunk {
+	struct kernel_pool_chunk *next;
+};
+
+struct kernel_pool_object {
+	struct kernel_pool_object *next;
+};
+
+static struct kernel_pool_object *kernel_pool_free[ARC_ACPI_POOL_CLASSES] = { 0 };
+static struct kernel_pool_chunk *kernel_pool_chunks = NULL;
+static uint8_t *kernel_pool_bump = NULL;
+static uint8_t *kernel_pool_bump_end = NULL;
+static ARC_ACPIPoolStats kernel_pool_stats = { 0 };
+static bool kernel_pool_lock = false;
+
+// Size of the ring holding deferred work, must be a power of two
+#define KERNEL_WORK_MAX 64
+// Interval at which a thread running work inline retries while the ring is
+// busy
+#define KERNEL_WORK_RETRY_NS 10000
+
+// uACPI only installs a handler for the SCI, so a single hard IRQ stub is
+// provided
+struct kernel_irq {
+	uacpi_interrupt_handler handler;
+	uacpi_handle ctx;
+	uint32_t gsi;
+	uint32_t vector;
+	uint8_t flags;
+	// Number of times the stub fired since the bottom half last ran
+	uint32_t pending;
+};
+
+struct kernel_work {
+	uacpi_work_handler handler;
+	uacpi_handle ctx;
+	bool ready;
 };
 
+static struct kernel_irq kernel_sci = { 0 };
+static struct kernel_work kernel_work_ring[KERNEL_WORK_MAX] = { 0 };
+// Producers reserve slots by advancing the tail, the single consumer advances
+// the head
+static uint64_t kernel_work_head = 0;
+static uint64_t kernel_work_tail = 0;
+// Number of work items whose handler has returned
+static uint64_t kernel_work_done = 0;
+static uint32_t kernel_work_waiters = 0;
+// Thread currently consuming the ring, see kernel_self
+static void *kernel_work_consumer = NULL;
+// Thread running acpi_handle_events, NULL until it is first called
+static void *kernel_worker = NULL;
+// Bumped for every SCI and scheduled work, the worker parks on it while idle
+static uint64_t kernel_events = 0;
+static uint32_t kernel_worker_parked = 0;
+
+// Let the worker know of a new SCI or work, callable from interrupt context
+static void kernel_post_event() {
+	__atomic_add_fetch(&kernel_events, 1, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&kernel_worker_parked, __ATOMIC_SEQ_CST) != 0) {
+		smp_unpark(&kernel_events, 1);
+	}
+}
+
+static inline void kernel_cpu_relax() {
+#ifdef ARC_TARGET_ARCH_X86_64
+	__builtin_ia32_pause();
+#endif
+}
+
+static inline void kernel_lock(bool *lock) {
+	while (__atomic_test_and_set(lock, __ATOMIC_ACQUIRE)) {
+		kernel_cpu_relax();
+	}
+}
+
+static inline void kernel_unlock(bool *lock) {
+	__atomic_clear(lock, __ATOMIC_RELEASE);
+}
+
 /*
  * Convenience initialization/deinitialization hooks that will be called by
  * uACPI automatically when appropriate if compiled-in.
@@ -214,21 +387,27 @@ uacpi_status uacpi_kernel_pci_write(uacpi_pci_address *address, uacpi_size offse
 /*
  * Map a SystemIO address at [base, base + len) and return a kernel-implemented
  * handle that can be used for reading and writing the IO range.
+ *
+ * The range is validated here once. uACPI only issues accesses within the
+ * range it mapped, so reads and writes through the handle go straight to the
+ * port.
  */
 uacpi_status uacpi_kernel_io_map(uacpi_io_addr base, uacpi_size len, uacpi_handle *out_handle) {
-	(void)len;
-	ARC_DEBUG(WARN, "IO MAP\n");
+	if (len == 0 || base >= KERNEL_IO_SPACE_SIZE || len > KERNEL_IO_SPACE_SIZE - base) {
+		ARC_DEBUG(ERR, "Invalid IO range 0x%"PRIx64" (%lu)\n", base, len);
+		return UACPI_STATUS_INVALID_ARGUMENT;
+	}
 
 	struct kernel_io_handle *handle = alloc(sizeof(*handle));
 
 	if (handle == NULL) {
 		ARC_DEBUG(ERR, "Failed to create handle\n");
-		return UACPI_STATUS_DENIED;
+		return UACPI_STATUS_OUT_OF_MEMORY;
 	}
 
-	handle->base = base;
-	handle->len = len;
-	
+	handle->base = (uint16_t)base;
+	handle->len = (uint32_t)len;
+
 	*out_handle = handle;
 
 	return UACPI_STATUS_OK;
@@ -239,7 +418,7 @@ void uacpi_kernel_io_unmap(uacpi_handle handle) {
 		ARC_DEBUG(ERR, "Failed to unmap handle\n");
 		return;
 	}
-	
+
 	free(handle);
 
 	return;
@@ -255,30 +434,336 @@ void uacpi_kernel_io_unmap(uacpi_handle handle) {
  * be of the exact width.
  */
 uacpi_status uacpi_kernel_io_read(uacpi_handle handle, uacpi_size offset, uacpi_u8 byte_width, uacpi_u64 *value) {
-	(void)handle;
-	(void)offset;
-	(void)byte_width;
-	(void)value;
-	ARC_DEBUG(INFO, "IO RANGE READ\n");
-	return UACPI_STATUS_OK;
+	uint16_t port = ((struct kernel_io_handle *)handle)->base + offset;
+
+	switch (byte_width) {
+		case 1: {
+			*value = inb(port);
+			return UACPI_STATUS_OK;
+		}
+
+		case 2: {
+			*value = inw(port);
+			return UACPI_STATUS_OK;
+		}
+
+		case 4: {
+			*value = ind(port);
+			return UACPI_STATUS_OK;
+		}
+
+		default: {
+			return UACPI_STATUS_INVALID_ARGUMENT;
+		}
+	}
 }
+
 uacpi_status uacpi_kernel_io_write(uacpi_handle handle, uacpi_size offset, uacpi_u8 byte_width, uacpi_u64 value) {
-	(void)handle;
-	(void)offset;
-	(void)byte_width;
-	(void)value;
-	ARC_DEBUG(INFO, "IO RANGE WRITE\n");
-	return UACPI_STATUS_OK;
+	uint16_t port = ((struct kernel_io_handle *)handle)->base + offset;
+
+	switch (byte_width) {
+		case 1: {
+			outb(port, value);
+			return UACPI_STATUS_OK;
+		}
+
+		case 2: {
+			outw(port, value);
+			return UACPI_STATUS_OK;
+		}
+
+		case 4: {
+			outd(port, value);
+			return UACPI_STATUS_OK;
+		}
+
+		default: {
+			return UACPI_STATUS_INVALID_ARGUMENT;
+		}
+	}
+}
+
+// Map [base, end), or as much of it from base as is in the same state
+// (mapped or not), the caller maps the rest with further mappings
+static struct kernel_mapping *kernel_map_create(uint64_t base, uint64_t end) {
+	ARC_PagerTranslation translation = { 0 };
+	bool mapped = pager_translate((void *)Arc_KernelPageTables, ARC_PHYS_TO_HHDM(base), &translation) == 0;
+	uint64_t cursor = base + KERNEL_MAP_PAGE_SIZE;
+
+	while (cursor < end && (pager_translate((void *)Arc_KernelPageTables, ARC_PHYS_TO_HHDM(cursor), &translation) == 0) == mapped) {
+		cursor += KERNEL_MAP_PAGE_SIZE;
+	}
+
+	struct kernel_mapping *mapping = alloc(sizeof(*mapping));
+
+	if (mapping == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate mapping\n");
+		return NULL;
+	}
+
+	memset(mapping, 0, sizeof(*mapping));
+
+	mapping->base = base;
+	mapping->end = cursor;
+
+	// Ranges the HHDM already maps are RAM (i.e. ACPI tables and NVS), whose
+	// memory type is kept, as other kernel data may share their pages. The
+	// rest is MMIO, mapped uncached with large pages wherever the alignment
+	// of the range allows
+	if (mapped) {
+		mapping->state = KERNEL_MAP_BORROWED;
+		return mapping;
+	}
+
+	uint32_t attributes = (ARC_PAGER_PAT_UC << ARC_PAGER_PAT) | (1 << ARC_PAGER_NX) | (1 << ARC_PAGER_RW);
+	mapping->state = KERNEL_MAP_OWNED;
+
+	if (pager_map((void *)Arc_KernelPageTables, ARC_PHYS_TO_HHDM(base), base, cursor - base, attributes) != 0) {
+		ARC_DEBUG(ERR, "Failed to map 0x%"PRIx64"-0x%"PRIx64" uncached\n", base, cursor);
+		free(mapping);
+		return NULL;
+	}
+
+	return mapping;
+}
+
+static void kernel_map_destroy(struct kernel_mapping *mapping) {
+	void *virtual = (void *)ARC_PHYS_TO_HHDM(mapping->base);
+	size_t size = mapping->end - mapping->base;
+
+	switch (mapping->state) {
+		case KERNEL_MAP_OWNED: {
+			void *physical = NULL;
+			pager_unmap((void *)Arc_KernelPageTables, (uintptr_t)virtual, size, &physical);
+			break;
+		}
+	}
+
+	free(mapping);
+}
+
+// Tear down the least recently used unreferenced mapping, kernel_mappings_lock
+// must be held
+static void kernel_map_evict() {
+	struct kernel_mapping **victim = NULL;
+
+	for (struct kernel_mapping **link = &kernel_mappings; *link != NULL; link = &(*link)->next) {
+		if ((*link)->refs == 0 && (victim == NULL || (*link)->last_use < (*victim)->last_use)) {
+			victim = link;
+		}
+	}
+
+	if (victim == NULL) {
+		return;
+	}
+
+	struct kernel_mapping *mapping = *victim;
+	*victim = mapping->next;
+	kernel_mappings_idle--;
+
+	kernel_map_destroy(mapping);
+}
+
+// Drop a reference on every mapping overlapping [base, end), kernel_mappings_lock
+// must be held
+static void kernel_map_release(uint64_t base, uint64_t end) {
+	for (struct kernel_mapping *mapping = kernel_mappings; mapping != NULL && mapping->base < end; mapping = mapping->next) {
+		if (mapping->end <= base || mapping->refs == 0) {
+			continue;
+		}
+
+		mapping->last_use = kernel_mappings_clock++;
+
+		if (--mapping->refs == 0) {
+			kernel_mappings_idle++;
+		}
+	}
+
+	while (kernel_mappings_idle > KERNEL_MAP_IDLE_MAX) {
+		kernel_map_evict();
+	}
+}
+
+// Take a reference on every mapping overlapping [base, end), creating mappings
+// for any uncovered gaps, kernel_mappings_lock must be held
+static int kernel_map_acquire(uint64_t base, uint64_t end) {
+	struct kernel_mapping **link = &kernel_mappings;
+	uint64_t cursor = base;
+
+	while (cursor < end) {
+		struct kernel_mapping *next = *link;
+
+		if (next != NULL && next->end <= cursor) {
+			link = &next->next;
+			continue;
+		}
+
+		if (next == NULL || next->base > cursor) {
+			// Gap at the cursor, which extends up to the next mapping
+			uint64_t gap_end = (next == NULL || next->base > end) ? end : next->base;
+			struct kernel_mapping *mapping = kernel_map_create(cursor, gap_end);
+
+			if (mapping == NULL) {
+				kernel_map_release(base, cursor);
+				return -1;
+			}
+
+			mapping->next = next;
+			*link = mapping;
+			next = mapping;
+		} else if (next->refs == 0) {
+			kernel_mappings_idle--;
+		}
+
+		next->refs++;
+		next->last_use = kernel_mappings_clock++;
+		cursor = next->end;
+		link = &next->next;
+	}
+
+	return 0;
 }
 
 void *uacpi_kernel_map(uacpi_phys_addr addr, uacpi_size len) {
-	(void)len;
+	uint64_t base = addr & ~(uint64_t)(KERNEL_MAP_PAGE_SIZE - 1);
+	uint64_t end = (addr + len + KERNEL_MAP_PAGE_SIZE - 1) & ~(uint64_t)(KERNEL_MAP_PAGE_SIZE - 1);
+
+	kernel_lock(&kernel_mappings_lock);
+	int r = kernel_map_acquire(base, end);
+	kernel_unlock(&kernel_mappings_lock);
+
+	if (r != 0) {
+		ARC_DEBUG(ERR, "Failed to map 0x%"PRIx64" (%lu)\n", addr, len);
+		return NULL;
+	}
+
 	return (void *)ARC_PHYS_TO_HHDM(addr);
 }
 
 void uacpi_kernel_unmap(void *addr, uacpi_size len) {
-	(void)addr;
-	(void)len;
+	uint64_t phys = ARC_HHDM_TO_PHYS(addr);
+	uint64_t base = phys & ~(uint64_t)(KERNEL_MAP_PAGE_SIZE - 1);
+	uint64_t end = (phys + len + KERNEL_MAP_PAGE_SIZE - 1) & ~(uint64_t)(KERNEL_MAP_PAGE_SIZE - 1);
+
+	kernel_lock(&kernel_mappings_lock);
+	kernel_map_release(base, end);
+	kernel_unlock(&kernel_mappings_lock);
+}
+
+static inline int kernel_pool_class(size_t size) {
+	for (int i = 0; i < ARC_ACPI_POOL_CLASSES; i++) {
+		if (size <= kernel_pool_sizes[i]) {
+			return i;
+		}
+	}
+
+	return KERNEL_POOL_LARGE;
+}
+
+static void kernel_pool_account_alloc(int class, size_t size) {
+	ARC_ACPIPoolClassStats *stats = &kernel_pool_stats.classes[class];
+
+	stats->allocations++;
+	if (++stats->in_use > stats->peak) {
+		stats->peak = stats->in_use;
+	}
+
+	kernel_pool_stats.bytes += size;
+	if (kernel_pool_stats.bytes > kernel_pool_stats.peak_bytes) {
+		kernel_pool_stats.peak_bytes = kernel_pool_stats.bytes;
+	}
+}
+
+static void kernel_pool_account_free(int class, size_t size) {
+	kernel_pool_stats.classes[class].frees++;
+	kernel_pool_stats.classes[class].in_use--;
+	kernel_pool_stats.bytes -= size;
+}
+
+// Carve an object of the given class, kernel_pool_lock must be held
+static void *kernel_pool_carve(int class) {
+	size_t size = kernel_pool_sizes[class] + KERNEL_POOL_HEADER;
+
+	if (kernel_pool_bump == NULL || (size_t)(kernel_pool_bump_end - kernel_pool_bump) < size) {
+		struct kernel_pool_chunk *chunk = alloc(KERNEL_POOL_CHUNK_SIZE);
+
+		if (chunk == NULL) {
+			return NULL;
+		}
+
+		chunk->next = kernel_pool_chunks;
+		kernel_pool_chunks = chunk;
+		kernel_pool_stats.arena_size += KERNEL_POOL_CHUNK_SIZE;
+
+		// The tail of the previous chunk is left unused
+		kernel_pool_bump = (uint8_t *)chunk + KERNEL_POOL_ALIGN;
+		kernel_pool_bump_end = (uint8_t *)chunk + KERNEL_POOL_CHUNK_SIZE;
+	}
+
+	void *object = kernel_pool_bump;
+	kernel_pool_bump += size;
+
+	return object;
+}
+
+static void *kernel_pool_alloc(size_t size) {
+	int class = kernel_pool_class(size);
+	uint8_t *object = NULL;
+
+	if (class == KERNEL_POOL_LARGE) {
+		object = alloc(size + KERNEL_POOL_HEADER);
+	}
+
+	kernel_lock(&kernel_pool_lock);
+
+	if (class != KERNEL_POOL_LARGE) {
+		struct kernel_pool_object *head = kernel_pool_free[class];
+
+		if (head != NULL) {
+			kernel_pool_free[class] = head->next;
+			object = (uint8_t *)head;
+		} else {
+			object = kernel_pool_carve(class);
+		}
+	}
+
+	if (object != NULL) {
+		kernel_pool_account_alloc(class, size);
+	}
+
+	kernel_unlock(&kernel_pool_lock);
+
+	if (object == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate %lu bytes\n", size);
+		return NULL;
+	}
+
+#ifndef UACPI_SIZED_FREES
+	*(uint64_t *)object = size;
+#endif
+
+	return object + KERNEL_POOL_HEADER;
+}
+
+static void kernel_pool_free_sized(void *mem, size_t size) {
+	uint8_t *object = (uint8_t *)mem - KERNEL_POOL_HEADER;
+	int class = kernel_pool_class(size);
+
+	kernel_lock(&kernel_pool_lock);
+
+	if (class != KERNEL_POOL_LARGE) {
+		struct kernel_pool_object *head = (struct kernel_pool_object *)object;
+		head->next = kernel_pool_free[class];
+		kernel_pool_free[class] = head;
+	}
+
+	kernel_pool_account_free(class, size);
+
+	kernel_unlock(&kernel_pool_lock);
+
+	if (class == KERNEL_POOL_LARGE) {
+		free(object);
+	}
 }
 
 /*
@@ -286,11 +771,7 @@ void uacpi_kernel_unmap(void *addr, uacpi_size len) {
  * The contents of the allocated memory are unspecified.
  */
 void *uacpi_kernel_alloc(uacpi_size size) {
-	void *r = alloc(size);
-	if (r == NULL) {
-		ARC_DEBUG(INFO, "Allocating %lu (%p)\n", size, r);
-	}
-	return r;
+	return kernel_pool_alloc(size);
 }
 
 /*
@@ -298,11 +779,16 @@ void *uacpi_kernel_alloc(uacpi_size size) {
  * The returned memory block is expected to be zero-filled.
  */
 void *uacpi_kernel_calloc(uacpi_size count, uacpi_size size) {
-	void *r = calloc(size, count);
-	if (r == NULL) {
-		ARC_DEBUG(INFO, "Allocating %lu %lu (%p)\n", size, count, r);
+	if (size != 0 && count > SIZE_MAX / size) {
+		return NULL;
 	}
-	memset(r, 0, size * count);
+
+	void *r = kernel_pool_alloc(count * size);
+
+	if (r != NULL) {
+		memset(r, 0, count * size);
+	}
+
 	return r;
 }
 
@@ -322,91 +808,185 @@ void uacpi_kernel_free(void *mem) {
 		return;
 	}
 
-	if (free(mem) == 0) {
-		ARC_DEBUG(ERR, "Freeing %p\n", mem);
-	}
+	kernel_pool_free_sized(mem, *(uint64_t *)((uint8_t *)mem - KERNEL_POOL_HEADER));
 }
 #else
-void uacpi_kernel_free(void *mem, uacpi_size size_hint) { return UACPI_STATUS_OK; }
+void uacpi_kernel_free(void *mem, uacpi_size size_hint) {
+	if (mem == NULL) {
+		return;
+	}
+
+	kernel_pool_free_sized(mem, size_hint);
+}
 #endif
 
-#ifndef UACPI_FORMATTED_LOGGING
-void uacpi_kernel_log(uacpi_log_level level, const uacpi_char* fmt) {
-	switch (level) {
-		case UACPI_LOG_INFO: {
-			ARC_DEBUG(INFO, "[uACPI]: %s", fmt);
-			break;
-		}
-		case UACPI_LOG_TRACE: {
-			ARC_DEBUG(INFO, "[uACPI TRACE]: %s", fmt);
-			break;
-		}
-		case UACPI_LOG_WARN: {
-			ARC_DEBUG(WARN, "[uACPI]: %s", fmt);
-			break;
-		}
-		case UACPI_LOG_DEBUG: {
-			ARC_DEBUG(INFO, "[uACPI DEBUG]: %s", fmt);
-			break;
-		}
-		case UACPI_LOG_ERROR: {
-			ARC_DEBUG(ERR, "[uACPI]: %s", fmt);
-			break;
+int acpi_get_pool_stats(ARC_ACPIPoolStats *out) {
+	if (out == NULL) {
+		return -1;
+	}
+
+	kernel_lock(&kernel_pool_lock);
+	*out = kernel_pool_stats;
+	kernel_unlock(&kernel_pool_lock);
+
+	for (int i = 0; i < ARC_ACPI_POOL_CLASSES; i++) {
+		out->classes[i].size = kernel_pool_sizes[i];
+	}
+
+	return 0;
+}
+
+int acpi_release_pool() {
+	kernel_lock(&kernel_pool_lock);
+
+	for (int i = 0; i <= KERNEL_POOL_LARGE; i++) {
+		if (kernel_pool_stats.classes[i].in_use != 0) {
+			kernel_unlock(&kernel_pool_lock);
+			return -1;
 		}
 	}
-	return;
+
+	struct kernel_pool_chunk *chunk = kernel_pool_chunks;
+	while (chunk != NULL) {
+		struct kernel_pool_chunk *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+
+	kernel_pool_chunks = NULL;
+	kernel_pool_bump = NULL;
+	kernel_pool_bump_end = NULL;
+	memset(kernel_pool_free, 0, sizeof(kernel_pool_free));
+	memset(&kernel_pool_stats, 0, sizeof(kernel_pool_stats));
+
+	kernel_unlock(&kernel_pool_lock);
+
+	return 0;
 }
-#else
-UACPI_PRINTF_DECL(2, 3)
-void uacpi_kernel_log(uacpi_log_level, const uacpi_char*, ...) { return UACPI_STATUS_OK; }
-void uacpi_kernel_vlog(uacpi_log_level, const uacpi_char*, uacpi_va_list) { return UACPI_STATUS_OK; }
-#endif
 
 /*
  * Returns the number of 100 nanosecond ticks elapsed since boot,
  * strictly monotonic.
  */
+static void kernel_find_pm_timer() {
+	struct acpi_fadt *fadt = NULL;
+	int32_t port = -1;
+
+	if (uacpi_table_fadt(&fadt) == UACPI_STATUS_OK && fadt != NULL) {
+		if (fadt->x_pm_tmr_blk.address != 0 && fadt->x_pm_tmr_blk.address_space_id == ARC_ACPI_GAS_SPACE_IO) {
+			port = (int32_t)fadt->x_pm_tmr_blk.address;
+		} else if (fadt->pm_tmr_blk != 0) {
+			port = (int32_t)fadt->pm_tmr_blk;
+		}
+
+		__atomic_store_n(&kernel_pm_timer_mask, (fadt->flags & ACPI_TMR_VAL_EXT) ? UINT32_MAX : 0xFFFFFF, __ATOMIC_RELAXED);
+	}
+
+	__atomic_store_n(&kernel_pm_timer_port, port, __ATOMIC_RELEASE);
+}
+
+static uint64_t kernel_pm_timer_ns() {
+	uint32_t mask = __atomic_load_n(&kernel_pm_timer_mask, __ATOMIC_RELAXED);
+	uint64_t last = __atomic_load_n(&kernel_pm_timer_last, __ATOMIC_RELAXED);
+	uint64_t now = 0;
+
+	// Extend the counter as hpet_read does, it wraps every 4.7 seconds with
+	// 24 bits
+	do {
+		uint32_t value = ind((uint16_t)kernel_pm_timer_port) & mask;
+		now = (last & ~(uint64_t)mask) | value;
+
+		if (now < last) {
+			now += (uint64_t)mask + 1;
+		}
+	} while (!__atomic_compare_exchange_n(&kernel_pm_timer_last, &last, now, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	return (now / KERNEL_PM_TIMER_HZ) * 1000000000 + ((now % KERNEL_PM_TIMER_HZ) * 1000000000) / KERNEL_PM_TIMER_HZ;
+}
+
+// Nanoseconds since an arbitrary point, from the HPET, else the PM timer,
+// else an estimate that advances with every read
+static uint64_t kernel_clock_ns() {
+	if (hpet_present()) {
+		return hpet_get_ns();
+	}
+
+	if (__atomic_load_n(&kernel_pm_timer_port, __ATOMIC_ACQUIRE) == 0) {
+		kernel_find_pm_timer();
+	}
+
+	if (kernel_pm_timer_port > 0) {
+		return kernel_pm_timer_ns();
+	}
+
+	return __atomic_add_fetch(&kernel_clock_estimate, KERNEL_CLOCK_POLL_NS, __ATOMIC_RELAXED);
+}
+
 uacpi_u64 uacpi_kernel_get_ticks(void) {
-	ARC_DEBUG(INFO, "There are no ticks\n");
-	return UACPI_STATUS_OK;
+	return kernel_clock_ns() / 100;
+}
+
+static void kernel_wait_ns(uint64_t ns) {
+	uint64_t deadline = kernel_clock_ns() + ns;
+
+	while (kernel_clock_ns() < deadline) {
+		kernel_cpu_relax();
+	}
 }
 
 /*
  * Spin for N microseconds.
  */
 void uacpi_kernel_stall(uacpi_u8 usec) {
-	(void)usec;
-	ARC_DEBUG(INFO, "Not stalling\n");
-	return;
+	kernel_wait_ns((uint64_t)usec * 1000);
 }
 
 /*
  * Sleep for N milliseconds.
  */
 void uacpi_kernel_sleep(uacpi_u64 msec) {
-	(void)msec;
-	ARC_DEBUG(INFO, "Not sleeping\n");
-	return;
+	// Nothing unparks the word, so the thread is switched away from until
+	// the timeout passes, returning early only on spurious wake ups
+	uint64_t word = 0;
+	uint64_t deadline = kernel_clock_ns() + msec * 1000000;
+	uint64_t now = 0;
+
+	while ((now = kernel_clock_ns()) < deadline) {
+		smp_park(&word, 0, deadline - now);
+	}
 }
 
 /*
  * Create/free an opaque non-recursive kernel mutex object.
  */
 uacpi_handle uacpi_kernel_create_mutex(void) {
-	ARC_Mutex *mutex = NULL;
+	struct kernel_mutex *mutex = alloc(sizeof(*mutex));
 
-	if (init_mutex(&mutex) != 0) {
+	if (mutex == NULL) {
 		ARC_DEBUG(ERR, "Failed to allocate mutex\n");
 		return NULL;
 	}
 
+	memset(mutex, 0, sizeof(*mutex));
+
 	return mutex;
 }
 
 void uacpi_kernel_free_mutex(uacpi_handle handle) {
-	if (uninit_mutex((ARC_Mutex *)handle) != 0) {
+	struct kernel_mutex *mutex = (struct kernel_mutex *)handle;
+
+	if (mutex == NULL) {
 		ARC_DEBUG(ERR, "Failed to destroy mutex %p\n", handle);
+		return;
 	}
+
+	if (mutex->stats.contended > 0) {
+		ARC_DEBUG(INFO, "Mutex %p: %"PRIu64" acquisitions, %"PRIu64" contended (%"PRIu64" spun, %"PRIu64" blocked, %"PRIu64" timed out)\n",
+			  handle, mutex->acquisitions, mutex->stats.contended, mutex->stats.spun,
+			  mutex->stats.blocked, mutex->stats.timeouts);
+	}
+
+	free(mutex);
 }
 
 /*
@@ -437,17 +1017,136 @@ uacpi_thread_id uacpi_kernel_get_thread_id(void) {
 	return (uacpi_thread_id)thread->tid;
 }
 
+static inline bool kernel_mutex_try(struct kernel_mutex *mutex, uint64_t self) {
+	uint64_t expected = 0;
+	return __atomic_compare_exchange_n(&mutex->owner, &expected, self, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void kernel_mutex_count(uint64_t *local, uint64_t *total) {
+	__atomic_add_fetch(local, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(total, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Returns true if the owner of the mutex is currently executing on a
+ * processor other than the invoking one, in which case it is expected to
+ * release the mutex shortly and spinning is cheaper than blocking.
+ */
+static bool kernel_mutex_owner_running(struct kernel_mutex *mutex, uint64_t owner, ARC_ProcessorDescriptor *self) {
+	ARC_ProcessorDescriptor *proc = __atomic_load_n(&mutex->owner_proc, __ATOMIC_RELAXED);
+
+	if (proc == NULL || proc == self) {
+		return false;
+	}
+
+	ARC_Thread *thread = __atomic_load_n(&proc->thread, __ATOMIC_RELAXED);
+
+	return thread != NULL && thread->tid + 1 == owner;
+}
+
+/*
+ * Wait for the mutex to be released by its current owner, returning false
+ * if the deadline passes first. The waiter spins while the owner is running
+ * and parks on the owner word otherwise, to be woken by the release.
+ */
+static bool kernel_mutex_wait(struct kernel_mutex *mutex, uint64_t self, uacpi_u16 timeout) {
+	uint64_t deadline = kernel_clock_ns() + (uint64_t)timeout * 1000000;
+	ARC_ProcessorDescriptor *proc = smp_get_proc_desc();
+
+	// Spin phase, only worthwhile while the owner is making progress
+	uint64_t owner = 0;
+	while ((owner = __atomic_load_n(&mutex->owner, __ATOMIC_RELAXED)) != 0
+	       && kernel_mutex_owner_running(mutex, owner, proc)) {
+		for (int i = 0; i < KERNEL_MUTEX_SPIN_BATCH; i++) {
+			kernel_cpu_relax();
+		}
+
+		if (timeout != KERNEL_MUTEX_INFINITE && kernel_clock_ns() >= deadline) {
+			return false;
+		}
+	}
+
+	if (kernel_mutex_try(mutex, self)) {
+		kernel_mutex_count(&mutex->stats.spun, &kernel_mutex_totals.spun);
+		return true;
+	}
+
+	// Blocking phase, the owner has been preempted or is waiting itself.
+	// Announcing the waiter before the next try pairs with the release
+	// clearing the owner before looking for waiters
+	kernel_mutex_count(&mutex->stats.blocked, &kernel_mutex_totals.blocked);
+	__atomic_add_fetch(&mutex->waiters, 1, __ATOMIC_SEQ_CST);
+
+	bool acquired = false;
+
+	while (!(acquired = kernel_mutex_try(mutex, self))) {
+		uint64_t now = kernel_clock_ns();
+
+		if (timeout != KERNEL_MUTEX_INFINITE && now >= deadline) {
+			break;
+		}
+
+		uint64_t owner = __atomic_load_n(&mutex->owner, __ATOMIC_SEQ_CST);
+
+		if (owner != 0) {
+			smp_park(&mutex->owner, owner, timeout == KERNEL_MUTEX_INFINITE ? ARC_SMP_PARK_FOREVER : deadline - now);
+		}
+	}
+
+	__atomic_sub_fetch(&mutex->waiters, 1, __ATOMIC_RELAXED);
+
+	return acquired;
+}
+
 /*
  * Try to acquire the mutex with a millisecond timeout.
  * A timeout value of 0xFFFF implies infinite wait.
+ *
+ * The mutex is acquired without any locking on the uncontended path. If
+ * contended, the caller spins for as long as the owner is running on another
+ * processor and then parks until the release or the deadline.
  */
 uacpi_bool uacpi_kernel_acquire_mutex(uacpi_handle handle, uacpi_u16 timeout) {
-	(void)timeout;
-	return mutex_lock((ARC_Mutex *)handle) == 0;
+	struct kernel_mutex *mutex = (struct kernel_mutex *)handle;
+	uint64_t self = uacpi_kernel_get_thread_id() + 1;
+
+	if (!kernel_mutex_try(mutex, self)) {
+		kernel_mutex_count(&mutex->stats.contended, &kernel_mutex_totals.contended);
+
+		if (timeout == KERNEL_MUTEX_TRYLOCK || !kernel_mutex_wait(mutex, self, timeout)) {
+			kernel_mutex_count(&mutex->stats.timeouts, &kernel_mutex_totals.timeouts);
+			return UACPI_FALSE;
+		}
+	}
+
+	__atomic_store_n(&mutex->owner_proc, smp_get_proc_desc(), __ATOMIC_RELAXED);
+	mutex->acquisitions++;
+
+	return UACPI_TRUE;
 }
 
 void uacpi_kernel_release_mutex(uacpi_handle handle) {
-	mutex_unlock((ARC_Mutex *)handle);
+	struct kernel_mutex *mutex = (struct kernel_mutex *)handle;
+
+	__atomic_store_n(&mutex->owner_proc, NULL, __ATOMIC_RELAXED);
+	__atomic_store_n(&mutex->owner, 0, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&mutex->waiters, __ATOMIC_SEQ_CST) != 0) {
+		smp_unpark(&mutex->owner, 1);
+	}
+}
+
+int acpi_get_mutex_stats(ARC_ACPIMutexStats *out) {
+	if (out == NULL) {
+		return -1;
+	}
+
+	out->contended = __atomic_load_n(&kernel_mutex_totals.contended, __ATOMIC_RELAXED);
+	out->spun = __atomic_load_n(&kernel_mutex_totals.spun, __ATOMIC_RELAXED);
+	out->blocked = __atomic_load_n(&kernel_mutex_totals.blocked, __ATOMIC_RELAXED);
+	out->timeouts = __atomic_load_n(&kernel_mutex_totals.timeouts, __ATOMIC_RELAXED);
+
+	return 0;
 }
 
 /*
@@ -496,6 +1195,18 @@ uacpi_status uacpi_kernel_handle_firmware_request(uacpi_firmware_request *req) {
 	return UACPI_STATUS_OK;
 }
 
+// Hard IRQ half of the SCI. The line is level triggered, so it is masked
+// until the bottom half has run the handler and the source has been cleared
+ARC_DEFINE_IRQ_HANDLER(acpi_sci) {
+	if (kernel_sci.handler != NULL) {
+		interrupt_map_gsi(kernel_sci.gsi, kernel_sci.vector, smp_get_processor_id(), kernel_sci.flags | (1 << ARC_INTERRUPT_FLAGS_MASKED));
+		__atomic_add_fetch(&kernel_sci.pending, 1, __ATOMIC_RELEASE);
+		kernel_post_event();
+	}
+
+	interrupt_end();
+}
+
 /*
  * Install an interrupt handler at 'irq', 'ctx' is passed to the provided
  * handler for every invocation.
@@ -504,10 +1215,64 @@ uacpi_status uacpi_kernel_handle_firmware_request(uacpi_firmware_request *req) {
  * refer to this handler from other API.
  */
 uacpi_status uacpi_kernel_install_interrupt_handler(uacpi_u32 irq, uacpi_interrupt_handler handler, uacpi_handle ctx, uacpi_handle *out_irq_handle) {
-	(void)handler;
-	(void)ctx;
-	(void)out_irq_handle;
-	ARC_DEBUG(INFO, "Installing IRQ handler for %d\n", irq);
+	if (kernel_sci.handler != NULL) {
+		ARC_DEBUG(ERR, "Handler already installed for IRQ %d\n", kernel_sci.gsi);
+		return UACPI_STATUS_ALREADY_EXISTS;
+	}
+
+	// The SCI is sharable, level triggered and active low unless an
+	// override says otherwise
+	uint32_t gsi = irq;
+	uint8_t flags = (1 << ARC_INTERRUPT_FLAGS_TRIGGER) | (1 << ARC_INTERRUPT_FLAGS_ACTIVE);
+
+	ARC_MADTIterator it = NULL;
+	ARC_MADT_ISO *iso = NULL;
+	while ((iso = acpi_get_next_madt_entry(ARC_MADT_ENTRY_TYPE_INT_OVERRIDE_SRC, &it)) != NULL) {
+		if (iso->bus != 0 || iso->source != irq) {
+			continue;
+		}
+
+		gsi = iso->gsi;
+
+		// 0b01: Active high, 0b11: Active low, otherwise conforms
+		if (MASKED_READ(iso->flags, 0, 0b11) == 0b01) {
+			flags &= ~(1 << ARC_INTERRUPT_FLAGS_ACTIVE);
+		}
+
+		// 0b01: Edge triggered, 0b11: Level triggered, otherwise conforms
+		if (MASKED_READ(iso->flags, 2, 0b11) == 0b01) {
+			flags &= ~(1 << ARC_INTERRUPT_FLAGS_TRIGGER);
+		}
+
+		break;
+	}
+
+	int vector = interrupt_alloc_vector();
+
+	if (vector < 0) {
+		ARC_DEBUG(ERR, "No free vector for IRQ %d (GSI %d)\n", irq, gsi);
+		return UACPI_STATUS_INTERNAL_ERROR;
+	}
+
+	kernel_sci.ctx = ctx;
+	kernel_sci.gsi = gsi;
+	kernel_sci.vector = vector;
+	kernel_sci.flags = flags;
+	kernel_sci.pending = 0;
+	__atomic_store_n(&kernel_sci.handler, handler, __ATOMIC_RELEASE);
+
+	if (interrupt_set(NULL, kernel_sci.vector, ARC_NAME_IRQ(acpi_sci), true) != 0
+	    || interrupt_map_gsi(gsi, kernel_sci.vector, smp_get_processor_id(), flags) != 0) {
+		ARC_DEBUG(ERR, "Failed to route IRQ %d (GSI %d)\n", irq, gsi);
+		__atomic_store_n(&kernel_sci.handler, NULL, __ATOMIC_RELEASE);
+		interrupt_free_vector(kernel_sci.vector);
+		return UACPI_STATUS_INTERNAL_ERROR;
+	}
+
+	ARC_DEBUG(INFO, "Installed handler for IRQ %d (GSI %d, vector %d)\n", irq, gsi, kernel_sci.vector);
+
+	*out_irq_handle = &kernel_sci;
+
 	return UACPI_STATUS_OK;
 }
 
@@ -516,9 +1281,17 @@ uacpi_status uacpi_kernel_install_interrupt_handler(uacpi_u32 irq, uacpi_interru
  * 'out_irq_handle' during installation.
  */
 uacpi_status uacpi_kernel_uninstall_interrupt_handler(uacpi_interrupt_handler handler, uacpi_handle irq_handle) {
-	(void)handler;
-	(void)irq_handle;
-	ARC_DEBUG(INFO, "Uninstalling IRQ\n");
+	struct kernel_irq *irq = (struct kernel_irq *)irq_handle;
+
+	if (irq != &kernel_sci || irq->handler != handler) {
+		return UACPI_STATUS_NOT_FOUND;
+	}
+
+	interrupt_map_gsi(irq->gsi, irq->vector, smp_get_processor_id(), irq->flags | (1 << ARC_INTERRUPT_FLAGS_MASKED));
+	__atomic_store_n(&irq->handler, NULL, __ATOMIC_RELEASE);
+	__atomic_store_n(&irq->pending, 0, __ATOMIC_RELEASE);
+	interrupt_free_vector(irq->vector);
+
 	return UACPI_STATUS_OK;
 }
 
@@ -553,7 +1326,6 @@ void uacpi_kernel_free_spinlock(uacpi_handle handle) {
  * Note that lock is infalliable.
  */
 uacpi_cpu_flags uacpi_kernel_lock_spinlock(uacpi_handle handle) {
-	ARC_DEBUG(ERR, "Disable interrupts, RFLAGS\n");
 	if (spinlock_lock((ARC_Spinlock *)handle) != 0) {
 		ARC_DEBUG(ERR, "Failed to lock spinlock\n");
 	}
@@ -575,13 +1347,148 @@ void uacpi_kernel_unlock_spinlock(uacpi_handle handle, uacpi_cpu_flags flags) {
  */
 uacpi_status uacpi_kernel_schedule_work(uacpi_work_type type, uacpi_work_handler handler, uacpi_handle ctx) {
 	(void)type;
-	(void)handler;
-	(void)ctx;
-	ARC_DEBUG(INFO, "Schedule work\n");
+
+	uint64_t tail = __atomic_load_n(&kernel_work_tail, __ATOMIC_RELAXED);
+
+	do {
+		if (tail - __atomic_load_n(&kernel_work_head, __ATOMIC_ACQUIRE) >= KERNEL_WORK_MAX) {
+			ARC_DEBUG(ERR, "Work queue is full\n");
+			return UACPI_STATUS_OUT_OF_MEMORY;
+		}
+	} while (!__atomic_compare_exchange_n(&kernel_work_tail, &tail, tail + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	struct kernel_work *work = &kernel_work_ring[tail & (KERNEL_WORK_MAX - 1)];
+	work->handler = handler;
+	work->ctx = ctx;
+	__atomic_store_n(&work->ready, true, __ATOMIC_RELEASE);
+	kernel_post_event();
+
 	return UACPI_STATUS_OK;
 }
 
+// Identity of the invoking thread, or of the processor before there are
+// threads
+static inline void *kernel_self() {
+	ARC_Thread *thread = sched_current_thread();
+	return thread != NULL ? (void *)thread : (void *)smp_get_proc_desc();
+}
+
+/*
+ * Run deferred work in the order it was scheduled, unless another thread is
+ * already doing so. A slot is released before its handler runs, so a handler
+ * waiting for completion drains the work queued after its own.
+ */
+static int kernel_run_work(void *self) {
+	void *consumer = NULL;
+	bool nested = __atomic_load_n(&kernel_work_consumer, __ATOMIC_RELAXED) == self;
+
+	if (!nested && !__atomic_compare_exchange_n(&kernel_work_consumer, &consumer, self, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		return 0;
+	}
+
+	int handled = 0;
+	uint64_t head = __atomic_load_n(&kernel_work_head, __ATOMIC_RELAXED);
+
+	while (head != __atomic_load_n(&kernel_work_tail, __ATOMIC_ACQUIRE)) {
+		struct kernel_work *work = &kernel_work_ring[head & (KERNEL_WORK_MAX - 1)];
+
+		if (!__atomic_load_n(&work->ready, __ATOMIC_ACQUIRE)) {
+			// Slot reserved, but not yet filled in
+			break;
+		}
+
+		uacpi_work_handler handler = work->handler;
+		uacpi_handle ctx = work->ctx;
+
+		__atomic_store_n(&work->ready, false, __ATOMIC_RELAXED);
+		__atomic_store_n(&kernel_work_head, ++head, __ATOMIC_RELEASE);
+
+		handler(ctx);
+
+		__atomic_add_fetch(&kernel_work_done, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&kernel_work_waiters, __ATOMIC_SEQ_CST) != 0) {
+			smp_unpark(&kernel_work_done, UINT32_MAX);
+		}
+
+		handled++;
+		// A handler waiting for completion may have moved the head on
+		head = __atomic_load_n(&kernel_work_head, __ATOMIC_RELAXED);
+	}
+
+	if (!nested) {
+		__atomic_store_n(&kernel_work_consumer, NULL, __ATOMIC_RELEASE);
+	}
+
+	return handled;
+}
+
 /*
  * Blocks until all scheduled work is complete and the work queue becomes empty.
+ *
+ * Without a worker, or when called by the worker itself (i.e. from a work
+ * handler), nobody else would run the work, so it is run inline. Work whose
+ * handler is further up the stack of the caller cannot complete before it
+ * returns and is not waited for. Otherwise the caller parks until the worker
+ * has completed everything scheduled before the call.
  */
-uacpi_status uacpi_kernel_wait_for_work_completion(void) { return UACPI_STATUS_OK; }
+uacpi_status uacpi_kernel_wait_for_work_completion(void) {
+	uint64_t tail = __atomic_load_n(&kernel_work_tail, __ATOMIC_ACQUIRE);
+	void *self = kernel_self();
+	void *worker = __atomic_load_n(&kernel_worker, __ATOMIC_ACQUIRE);
+
+	bool run = worker == NULL || worker == self;
+
+	__atomic_add_fetch(&kernel_work_waiters, 1, __ATOMIC_SEQ_CST);
+
+	uint64_t done = 0;
+	while ((int64_t)((done = __atomic_load_n(&kernel_work_done, __ATOMIC_SEQ_CST)) - tail) < 0) {
+		if (!run) {
+			smp_park(&kernel_work_done, done, ARC_SMP_PARK_FOREVER);
+			continue;
+		}
+
+		kernel_run_work(self);
+
+		if (__atomic_load_n(&kernel_work_consumer, __ATOMIC_ACQUIRE) == self) {
+			break;
+		}
+
+		// Another thread is running the work, or a slot is still being
+		// filled in
+		smp_park(&kernel_work_done, done, KERNEL_WORK_RETRY_NS);
+	}
+
+	__atomic_sub_fetch(&kernel_work_waiters, 1, __ATOMIC_SEQ_CST);
+
+	return UACPI_STATUS_OK;
+}
+
+int acpi_handle_events() {
+	void *self = kernel_self();
+	__atomic_store_n(&kernel_worker, self, __ATOMIC_RELEASE);
+
+	uint64_t events = __atomic_load_n(&kernel_events, __ATOMIC_SEQ_CST);
+	int handled = acpi_flush_log();
+
+	// Bottom half of the SCI
+	uacpi_interrupt_handler handler = __atomic_load_n(&kernel_sci.handler, __ATOMIC_ACQUIRE);
+	if (handler != NULL && __atomic_exchange_n(&kernel_sci.pending, 0, __ATOMIC_ACQUIRE) != 0) {
+		handler(kernel_sci.ctx);
+		interrupt_map_gsi(kernel_sci.gsi, kernel_sci.vector, smp_get_processor_id(), kernel_sci.flags);
+		handled++;
+	}
+
+	handled += kernel_run_work(self);
+
+	if (handled > 0) {
+		return handled;
+	}
+
+	// Nothing to do, park until an SCI or work is posted. A post after
+	// events was read either sees the flag or makes the park return at once
+	__atomic_store_n(&kernel_worker_parked, 1, __ATOMIC_SEQ_CST);
+	smp_park(&kernel_events, events, ARC_SMP_PARK_FOREVER);
+	__atomic_store_n(&kernel_worker_parked, 0, __ATOMIC_SEQ_CST);
+
+	return 0;
+}
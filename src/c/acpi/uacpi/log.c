@@ -0,0 +1,233 @@
+/**
+ * @file log.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Buffer uACPI log messages in per-processor rings of formatted records, which
+ * are printed later, off of the path that produced them.
+*/
+#include "arch/acpi/acpi.h"
+#include "arch/info.h"
+#include "arch/smp.h"
+#include "global.h"
+#include "lib/util.h"
+#include "mm/allocator.h"
+#include "uacpi/kernel_api.h"
+
+#define LOG_MAX_PROCESSORS 64
+// Number of records in each processor's ring, must be a power of two
+#define LOG_RING_SIZE 128
+#define LOG_TEXT_SPACE 246
+
+// A message is copied into its record when it is logged, so the record holds
+// no references to the caller's memory
+struct log_record {
+	uint64_t cycles;
+	uint8_t level;
+	bool ready;
+	char text[LOG_TEXT_SPACE];
+};
+STATIC_ASSERT(sizeof(struct log_record) == 256, "Log record of wrong length");
+
+struct log_ring {
+	// Only advanced by the processor owning the ring (possibly from within
+	// an interrupt), records between head and tail are pending
+	uint64_t tail;
+	// Only advanced by the drainer
+	uint64_t head;
+	uint64_t dropped;
+	struct log_record records[LOG_RING_SIZE];
+};
+
+static struct log_ring *log_rings[LOG_MAX_PROCESSORS] = { 0 };
+static bool log_draining = false;
+
+static struct log_ring *log_get_ring() {
+	uint32_t id = smp_get_processor_id();
+
+	if (id >= LOG_MAX_PROCESSORS) {
+		return NULL;
+	}
+
+	struct log_ring *ring = __atomic_load_n(&log_rings[id], __ATOMIC_ACQUIRE);
+
+	if (ring != NULL) {
+		return ring;
+	}
+
+	ring = alloc(sizeof(*ring));
+
+	if (ring == NULL) {
+		return NULL;
+	}
+
+	memset(ring, 0, sizeof(*ring));
+
+	// An interrupt on this processor may have installed a ring already
+	struct log_ring *expected = NULL;
+	if (!__atomic_compare_exchange_n(&log_rings[id], &expected, ring, false, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+		free(ring);
+		return expected;
+	}
+
+	return ring;
+}
+
+static struct log_record *log_reserve(struct log_ring *ring) {
+	uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+	do {
+		if (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) >= LOG_RING_SIZE) {
+			__atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+			return NULL;
+		}
+	} while (!__atomic_compare_exchange_n(&ring->tail, &tail, tail + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	return &ring->records[tail & (LOG_RING_SIZE - 1)];
+}
+
+static void log_record(uacpi_log_level level, const char *text) {
+	if (level > ARC_ACPI_LOG_LEVEL) {
+		return;
+	}
+
+	struct log_ring *ring = log_get_ring();
+
+	if (ring == NULL) {
+		return;
+	}
+
+	struct log_record *record = log_reserve(ring);
+
+	if (record == NULL) {
+		return;
+	}
+
+	record->cycles = arch_get_cycles();
+	record->level = level;
+
+	// Truncated messages keep their terminator
+	size_t length = 0;
+
+	while (length < LOG_TEXT_SPACE - 1 && text[length] != 0) {
+		length++;
+	}
+
+	memcpy(record->text, text, length);
+	record->text[length] = 0;
+
+	__atomic_store_n(&record->ready, true, __ATOMIC_RELEASE);
+}
+
+#ifndef UACPI_FORMATTED_LOGGING
+void uacpi_kernel_log(uacpi_log_level level, const uacpi_char* str) {
+	log_record(level, str);
+}
+#else
+// Formatting is left to uACPI, with formatted logging only the format string
+// is recorded
+void uacpi_kernel_log(uacpi_log_level level, const uacpi_char* fmt, ...) {
+	log_record(level, fmt);
+}
+
+void uacpi_kernel_vlog(uacpi_log_level level, const uacpi_char* fmt, uacpi_va_list args) {
+	(void)args;
+	log_record(level, fmt);
+}
+#endif
+
+static void log_print(struct log_record *record) {
+	switch (record->level) {
+		case UACPI_LOG_ERROR: {
+			ARC_DEBUG(ERR, "[uACPI]: %s", record->text);
+			break;
+		}
+
+		case UACPI_LOG_WARN: {
+			ARC_DEBUG(WARN, "[uACPI]: %s", record->text);
+			break;
+		}
+
+		default: {
+			ARC_DEBUG(INFO, "[uACPI]: %s", record->text);
+			break;
+		}
+	}
+}
+
+int acpi_flush_log() {
+	if (__atomic_test_and_set(&log_draining, __ATOMIC_ACQUIRE)) {
+		// Someone else is already draining
+		return 0;
+	}
+
+	int printed = 0;
+
+	// Merge the rings by timestamp so messages come out in the order they
+	// were produced
+	while (true) {
+		struct log_ring *oldest = NULL;
+
+		for (int i = 0; i < LOG_MAX_PROCESSORS; i++) {
+			struct log_ring *ring = __atomic_load_n(&log_rings[i], __ATOMIC_ACQUIRE);
+
+			if (ring == NULL || ring->head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) {
+				continue;
+			}
+
+			struct log_record *record = &ring->records[ring->head & (LOG_RING_SIZE - 1)];
+
+			if (!__atomic_load_n(&record->ready, __ATOMIC_ACQUIRE)) {
+				continue;
+			}
+
+			if (oldest == NULL || record->cycles < oldest->records[oldest->head & (LOG_RING_SIZE - 1)].cycles) {
+				oldest = ring;
+			}
+		}
+
+		if (oldest == NULL) {
+			break;
+		}
+
+		struct log_record *record = &oldest->records[oldest->head & (LOG_RING_SIZE - 1)];
+		log_print(record);
+		printed++;
+
+		__atomic_store_n(&record->ready, false, __ATOMIC_RELAXED);
+		__atomic_store_n(&oldest->head, oldest->head + 1, __ATOMIC_RELEASE);
+	}
+
+	for (int i = 0; i < LOG_MAX_PROCESSORS; i++) {
+		struct log_ring *ring = __atomic_load_n(&log_rings[i], __ATOMIC_ACQUIRE);
+		uint64_t dropped = 0;
+
+		if (ring != NULL && (dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED)) != 0) {
+			ARC_DEBUG(WARN, "[uACPI]: Dropped %"PRIu64" messages on processor %d\n", dropped, i);
+		}
+	}
+
+	__atomic_clear(&log_draining, __ATOMIC_RELEASE);
+
+	return printed;
+}
@@ -0,0 +1,370 @@
+/**
+ * @file power.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Discover the idle (_CST) and performance (_PSS, _PCT, _CPC) states of the
+ * processors in the namespace, and choose idle states for them.
+*/
+#include "arch/power.h"
+#include "arch/smp.h"
+#include "global.h"
+#include "lib/util.h"
+#include "mm/allocator.h"
+#include "uacpi/namespace.h"
+#include "uacpi/utilities.h"
+
+// Tag of a generic register descriptor, the GAS follows after its length
+#define POWER_REGISTER_DESCRIPTOR 0x82
+#define POWER_REGISTER_GAS_OFFSET 3
+#define POWER_GAS_SPACE_FFH 0x7F
+
+// Entering a state only pays off if it is held for some multiple of its exit
+// latency
+#define POWER_RESIDENCY_FACTOR 2
+// Weight of the latest idle duration in the prediction, 1 / (1 << shift)
+#define POWER_PREDICTION_SHIFT 3
+
+// Indices of fields in the package returned by _CPC
+#define POWER_CPC_HIGHEST  2
+#define POWER_CPC_NOMINAL  3
+#define POWER_CPC_LOWEST_NONLINEAR 4
+#define POWER_CPC_LOWEST   5
+#define POWER_CPC_DESIRED  7
+
+static ARC_ProcessorPower *power_processors = NULL;
+static uint32_t power_processor_count = 0;
+
+static const uacpi_char *const power_processor_ids[] = {
+	"ACPI0007",
+	NULL
+};
+
+ARC_ProcessorPower *power_get_processor(uint32_t acpi_uid) {
+	for (uint32_t i = 0; i < power_processor_count; i++) {
+		if (power_processors[i].acpi_uid == acpi_uid) {
+			return &power_processors[i];
+		}
+	}
+
+	return NULL;
+}
+
+int power_set_latency_limit(uint32_t acpi_uid, uint64_t limit_ns) {
+	ARC_ProcessorPower *power = power_get_processor(acpi_uid);
+
+	if (power == NULL) {
+		return -1;
+	}
+
+	__atomic_store_n(&power->latency_limit_ns, limit_ns, __ATOMIC_RELAXED);
+
+	return 0;
+}
+
+ARC_CState *power_select_cstate(ARC_ProcessorPower *power, uint64_t until_ns) {
+	if (power == NULL) {
+		return NULL;
+	}
+
+	uint64_t predicted = until_ns;
+	if (power->predicted_ns != 0 && power->predicted_ns < predicted) {
+		predicted = power->predicted_ns;
+	}
+
+	uint64_t limit = __atomic_load_n(&power->latency_limit_ns, __ATOMIC_RELAXED);
+	ARC_CState *chosen = &power->cstates[0];
+
+	for (uint32_t i = 1; i < power->cstate_count; i++) {
+		ARC_CState *state = &power->cstates[i];
+
+		if (state->latency_ns <= limit && state->residency_ns <= predicted) {
+			chosen = state;
+		}
+	}
+
+	return chosen;
+}
+
+void power_idle_exit(ARC_ProcessorPower *power, uint64_t idle_ns) {
+	if (power == NULL) {
+		return;
+	}
+
+	// Only ever updated by the processor itself
+	if (power->predicted_ns == 0) {
+		power->predicted_ns = idle_ns;
+		return;
+	}
+
+	power->predicted_ns += (idle_ns >> POWER_PREDICTION_SHIFT) - (power->predicted_ns >> POWER_PREDICTION_SHIFT);
+}
+
+static int power_get_integer(uacpi_object_array *array, size_t index, uint64_t *out) {
+	if (index >= array->count || uacpi_object_get_integer(array->objects[index], out) != UACPI_STATUS_OK) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int power_get_register(uacpi_object_array *array, size_t index, ARC_ACPIGas *out) {
+	uacpi_data_view view = { 0 };
+
+	if (index >= array->count || uacpi_object_get_buffer(array->objects[index], &view) != UACPI_STATUS_OK) {
+		return -1;
+	}
+
+	if (view.length < POWER_REGISTER_GAS_OFFSET + sizeof(*out) || view.const_bytes[0] != POWER_REGISTER_DESCRIPTOR) {
+		return -1;
+	}
+
+	memcpy(out, view.const_bytes + POWER_REGISTER_GAS_OFFSET, sizeof(*out));
+
+	return 0;
+}
+
+static void power_add_cstate(ARC_ProcessorPower *power, ARC_CState *state) {
+	if (power->cstate_count >= ARC_POWER_MAX_CSTATES) {
+		return;
+	}
+
+	// Keep the states ordered by exit latency
+	uint32_t i = power->cstate_count;
+	for (; i > 0 && power->cstates[i - 1].latency_ns > state->latency_ns; i--) {
+		power->cstates[i] = power->cstates[i - 1];
+	}
+
+	power->cstates[i] = *state;
+	power->cstate_count++;
+}
+
+static void power_parse_cst(uacpi_object_array *cst, ARC_ProcessorPower *power) {
+	ARC_ProcessorPower parsed = { 0 };
+
+	// The first element is the number of states
+	for (size_t i = 1; i < cst->count; i++) {
+		uacpi_object_array package = { 0 };
+		ARC_ACPIGas reg = { 0 };
+		uint64_t type = 0;
+		uint64_t latency = 0;
+		uint64_t power_mw = 0;
+
+		if (uacpi_object_get_package(cst->objects[i], &package) != UACPI_STATUS_OK
+		    || power_get_register(&package, 0, &reg) != 0
+		    || power_get_integer(&package, 1, &type) != 0
+		    || power_get_integer(&package, 2, &latency) != 0
+		    || power_get_integer(&package, 3, &power_mw) != 0) {
+			continue;
+		}
+
+		ARC_CState state = {
+		        .type = type,
+		        .address = reg.address,
+		        .latency_ns = latency * 1000,
+		        .residency_ns = latency * 1000 * POWER_RESIDENCY_FACTOR,
+		        .power_mw = power_mw,
+		};
+
+		if (reg.space_id == POWER_GAS_SPACE_FFH) {
+			state.entry = ARC_CSTATE_ENTRY_FFH;
+			state.flags = reg.bit_offset;
+		} else if (reg.space_id == ARC_ACPI_GAS_SPACE_IO && type > 1) {
+			state.entry = ARC_CSTATE_ENTRY_IO;
+		} else if (type == 1) {
+			state.entry = ARC_CSTATE_ENTRY_HALT;
+		} else {
+			ARC_DEBUG(WARN, "Unsupported C%"PRIu64" entry in address space %d\n", type, reg.space_id);
+			continue;
+		}
+
+		power_add_cstate(&parsed, &state);
+	}
+
+	if (parsed.cstate_count > 0) {
+		memcpy(power->cstates, parsed.cstates, sizeof(parsed.cstates));
+		power->cstate_count = parsed.cstate_count;
+	}
+}
+
+static void power_parse_pss(uacpi_object_array *pss, ARC_ProcessorPower *power) {
+	if (pss->count == 0 || power->pstates != NULL) {
+		return;
+	}
+
+	power->pstates = alloc(pss->count * sizeof(*power->pstates));
+
+	if (power->pstates == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate P-states\n");
+		return;
+	}
+
+	for (size_t i = 0; i < pss->count; i++) {
+		uacpi_object_array package = { 0 };
+		uint64_t fields[6] = { 0 };
+
+		if (uacpi_object_get_package(pss->objects[i], &package) != UACPI_STATUS_OK) {
+			continue;
+		}
+
+		int j = 0;
+		for (; j < 6 && power_get_integer(&package, j, &fields[j]) == 0; j++);
+
+		if (j < 6) {
+			continue;
+		}
+
+		power->pstates[power->pstate_count++] = (ARC_PState){
+		        .frequency_mhz = fields[0],
+		        .power_mw = fields[1],
+		        .latency_us = fields[2],
+		        .bus_master_latency_us = fields[3],
+		        .control = fields[4],
+		        .status = fields[5],
+		};
+	}
+}
+
+static void power_parse_pct(uacpi_object_array *pct, ARC_ProcessorPower *power) {
+	power_get_register(pct, 0, &power->pstate_control);
+	power_get_register(pct, 1, &power->pstate_status);
+}
+
+static void power_parse_cpc(uacpi_object_array *cpc, ARC_ProcessorPower *power) {
+	if (cpc->count <= POWER_CPC_DESIRED) {
+		return;
+	}
+
+	// Capabilities described by registers rather than integers are left 0
+	// for the architecture to read
+	uint64_t value = 0;
+	if (power_get_integer(cpc, POWER_CPC_HIGHEST, &value) == 0) {
+		power->cpc.highest = value;
+	}
+	if (power_get_integer(cpc, POWER_CPC_NOMINAL, &value) == 0) {
+		power->cpc.nominal = value;
+	}
+	if (power_get_integer(cpc, POWER_CPC_LOWEST_NONLINEAR, &value) == 0) {
+		power->cpc.lowest_nonlinear = value;
+	}
+	if (power_get_integer(cpc, POWER_CPC_LOWEST, &value) == 0) {
+		power->cpc.lowest = value;
+	}
+
+	power->cpc.present = power_get_register(cpc, POWER_CPC_DESIRED, &power->cpc.desired) == 0;
+}
+
+// Evaluate a method returning a package, and parse it into power
+static void power_eval(uacpi_namespace_node *node, const char *method, void (*parse)(uacpi_object_array *, ARC_ProcessorPower *),
+                       ARC_ProcessorPower *power) {
+	uacpi_object *object = NULL;
+
+	if (uacpi_eval_simple_typed(node, method, UACPI_OBJECT_PACKAGE_BIT, &object) != UACPI_STATUS_OK) {
+		return;
+	}
+
+	uacpi_object_array package = { 0 };
+	if (uacpi_object_get_package(object, &package) == UACPI_STATUS_OK) {
+		parse(&package, power);
+	}
+
+	uacpi_object_unref(object);
+}
+
+static uacpi_ns_iteration_decision power_callback(void *user, uacpi_namespace_node *node) {
+	(void)user;
+
+	uacpi_object_type type = UACPI_OBJECT_UNINITIALIZED;
+	uint64_t uid = 0;
+
+	if (uacpi_namespace_node_type(node, &type) != UACPI_STATUS_OK) {
+		return UACPI_NS_ITERATION_DECISION_CONTINUE;
+	}
+
+	if (type == UACPI_OBJECT_PROCESSOR) {
+		uacpi_processor_info info = { 0 };
+
+		if (uacpi_object_get_processor_info(uacpi_namespace_node_get_object(node), &info) != UACPI_STATUS_OK) {
+			return UACPI_NS_ITERATION_DECISION_CONTINUE;
+		}
+
+		uid = info.id;
+	} else if (type != UACPI_OBJECT_DEVICE || !uacpi_device_matches_pnp_id(node, power_processor_ids)
+	           || uacpi_eval_simple_integer(node, "_UID", &uid) != UACPI_STATUS_OK) {
+		return UACPI_NS_ITERATION_DECISION_CONTINUE;
+	}
+
+	// Objects of processors absent from the MADT are of no use
+	ARC_ProcessorPower *power = power_get_processor(uid);
+
+	if (power == NULL) {
+		return UACPI_NS_ITERATION_DECISION_CONTINUE;
+	}
+
+	power_eval(node, "_CST", power_parse_cst, power);
+	power_eval(node, "_PSS", power_parse_pss, power);
+	power_eval(node, "_PCT", power_parse_pct, power);
+	power_eval(node, "_CPC", power_parse_cpc, power);
+
+	ARC_DEBUG(INFO, "Processor %d: %d C-states (deepest %d ns), %d P-states, %s CPC\n", power->acpi_uid, power->cstate_count,
+	          power->cstates[power->cstate_count - 1].latency_ns, power->pstate_count, power->cpc.present ? "with" : "without");
+
+	return UACPI_NS_ITERATION_DECISION_CONTINUE;
+}
+
+int init_power() {
+	uint32_t count = smp_get_topology_count();
+
+	if (count == 0) {
+		ARC_DEBUG(ERR, "No processors to discover power states of\n");
+		return -1;
+	}
+
+	power_processors = calloc(count, sizeof(*power_processors));
+
+	if (power_processors == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate processor power states\n");
+		return -1;
+	}
+
+	// Every processor can at least halt
+	for (uint32_t i = 0; i < count; i++) {
+		ARC_ProcessorPower *power = &power_processors[i];
+
+		power->acpi_uid = smp_get_topology(i)->acpi_uid;
+		power->cstates[0] = (ARC_CState){
+		        .type = 1,
+		        .entry = ARC_CSTATE_ENTRY_HALT,
+		        .latency_ns = 1000,
+		        .residency_ns = 1000,
+		};
+		power->cstate_count = 1;
+		power->latency_limit_ns = ARC_POWER_NO_LATENCY_LIMIT;
+	}
+
+	power_processor_count = count;
+
+	uacpi_namespace_for_each_node_depth_first(uacpi_namespace_root(), power_callback, NULL);
+
+	return 0;
+}
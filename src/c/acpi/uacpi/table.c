@@ -25,22 +25,99 @@
  * @DESCRIPTION
 */
 #include "arch/acpi/table.h"
+#include "arch/numa.h"
 #include "global.h"
+#include "mm/allocator.h"
 #include "uacpi/event.h"
 #include "uacpi/tables.h"
 
-size_t acpi_get_table(const char *id, void **out) {
+#define SDT_HEADER_SIZE 36
+// Offset of the first entry of the SRAT from the start of the table
+#define SRAT_ENTRIES_OFFSET (SDT_HEADER_SIZE + 12)
+#define PPTT_ENTRIES_OFFSET SDT_HEADER_SIZE
+#define DMAR_ENTRIES_OFFSET (SDT_HEADER_SIZE + 12)
+#define IVRS_ENTRIES_OFFSET (SDT_HEADER_SIZE + 12)
+// Offsets of the first device scope, or device entry
+#define DMAR_DRHD_SCOPES_OFFSET 16
+#define DMAR_RMRR_SCOPES_OFFSET 24
+#define IVRS_IVHD10_DEVICES_OFFSET 24
+#define IVRS_IVHD40_DEVICES_OFFSET 40
+
+struct numa_processor {
+        uint32_t id;
+        uint32_t node;
+};
+
+struct numa_range {
+        uint64_t base;
+        uint64_t end;
+        uint32_t node;
+};
+
+static uint32_t *numa_domains = NULL;
+static uint32_t numa_node_count = 0;
+static struct numa_processor *numa_processors = NULL;
+static uint32_t numa_processor_count = 0;
+static struct numa_range *numa_ranges = NULL;
+static uint32_t numa_range_count = 0;
+static uint8_t *numa_slit = NULL;
+static uint64_t numa_slit_size = 0;
+
+// Signatures of tables found missing, so that each is only reported once
+#define ACPI_MISSING_MAX 16
+static char acpi_missing[ACPI_MISSING_MAX][4] = { 0 };
+static uint32_t acpi_missing_count = 0;
+
+static void acpi_report_missing(const char *id) {
+        uint32_t count = __atomic_load_n(&acpi_missing_count, __ATOMIC_ACQUIRE);
+
+        for (uint32_t i = 0; i < count && i < ACPI_MISSING_MAX; i++) {
+                if (memcmp(acpi_missing[i], id, 4) == 0) {
+                        return;
+                }
+        }
+
+        // Most tables are optional, callers decide whether a missing one is
+        // an error
+        ARC_DEBUG(INFO, "No %.4s table\n", id);
+
+        uint32_t slot = __atomic_fetch_add(&acpi_missing_count, 1, __ATOMIC_ACQ_REL);
+
+        if (slot < ACPI_MISSING_MAX) {
+                memcpy(acpi_missing[slot], id, 4);
+        }
+}
+
+// Get a table including its header
+static size_t acpi_get_sdt(const char *id, void **out) {
         uacpi_table table = { 0 };
         int r = 0;
 
         if ((r = uacpi_table_find_by_signature(id, &table)) != UACPI_STATUS_OK) {
-                ARC_DEBUG(ERR, "Failed to get table (%d)\n", r);
+                if (r == UACPI_STATUS_NOT_FOUND) {
+                        acpi_report_missing(id);
+                } else {
+                        ARC_DEBUG(ERR, "Failed to get %.4s table (%d)\n", id, r);
+                }
+
                 return 0;
         }
 
-        *out = table.ptr + 44;
+        *out = table.ptr;
 
-        return table.hdr->length - 44;
+        return table.hdr->length;
+}
+
+size_t acpi_get_table(const char *id, void **out) {
+        size_t size = acpi_get_sdt(id, out);
+
+        if (size < 44) {
+                return 0;
+        }
+
+        *out += 44;
+
+        return size - 44;
 }
 
 void *acpi_get_next_madt_entry(int type, ARC_MADTIterator *it) {
@@ -107,3 +184,493 @@ int acpi_get_next_mcfg_entry(ARC_MCFGIterator *it) {
         *it = (ARC_MCFGEntry *)((uintptr_t)base + i);
         return 0;
 }
+
+void *acpi_get_next_srat_entry(int type, ARC_SRATIterator *it) {
+        if (type < 0 || type >= ARC_SRAT_ENTRY_TYPE_MAX || it == NULL) {
+                return NULL;
+        }
+
+        void *table = NULL;
+        size_t max = acpi_get_sdt("SRAT", &table);
+
+        if (max <= SRAT_ENTRIES_OFFSET) {
+                return NULL;
+        }
+
+        ARC_SRATEntry *base = table + SRAT_ENTRIES_OFFSET;
+        max -= SRAT_ENTRIES_OFFSET;
+
+        size_t i = 0;
+        ARC_SRATEntry *entry = *it;
+
+        if (*it != NULL) {
+                i = ((uintptr_t)*it - (uintptr_t)base) + entry->length;
+        }
+
+        for (; i < max; i += entry->length) {
+                entry = (void *)base + i;
+
+                if (entry->length == 0) {
+                        break;
+                }
+
+                if (entry->type == type) {
+                        *it = entry;
+                        return (void *)&entry->d;
+                }
+        }
+
+        *it = NULL;
+        return NULL;
+}
+
+void *acpi_get_next_pptt_entry(int type, ARC_PPTTIterator *it) {
+        if (type < 0 || type >= ARC_PPTT_ENTRY_TYPE_MAX || it == NULL) {
+                return NULL;
+        }
+
+        void *table = NULL;
+        size_t max = acpi_get_sdt("PPTT", &table);
+
+        if (max <= PPTT_ENTRIES_OFFSET) {
+                return NULL;
+        }
+
+        size_t i = PPTT_ENTRIES_OFFSET;
+        ARC_PPTTEntry *entry = *it;
+
+        if (*it != NULL) {
+                i = ((uintptr_t)*it - (uintptr_t)table) + entry->length;
+        }
+
+        for (; i < max; i += entry->length) {
+                entry = table + i;
+
+                if (entry->length == 0) {
+                        break;
+                }
+
+                if (entry->type == type) {
+                        *it = entry;
+                        return (void *)&entry->d;
+                }
+        }
+
+        *it = NULL;
+        return NULL;
+}
+
+ARC_PPTTEntry *acpi_get_pptt_entry(uint32_t offset) {
+        void *table = NULL;
+        size_t max = acpi_get_sdt("PPTT", &table);
+
+        if (offset < PPTT_ENTRIES_OFFSET || offset + 2 > max) {
+                return NULL;
+        }
+
+        ARC_PPTTEntry *entry = table + offset;
+
+        if (entry->length == 0 || offset + entry->length > max) {
+                return NULL;
+        }
+
+        return entry;
+}
+
+uint32_t acpi_get_pptt_offset(ARC_PPTTEntry *entry) {
+        void *table = NULL;
+
+        if (entry == NULL || acpi_get_sdt("PPTT", &table) == 0) {
+                return 0;
+        }
+
+        return (uintptr_t)entry - (uintptr_t)table;
+}
+
+uint64_t acpi_get_slit(uint8_t **matrix) {
+        if (matrix == NULL) {
+                return 0;
+        }
+
+        void *table = NULL;
+        size_t max = acpi_get_sdt("SLIT", &table);
+
+        if (max < SDT_HEADER_SIZE + sizeof(uint64_t)) {
+                return 0;
+        }
+
+        uint64_t count = *(uint64_t *)(table + SDT_HEADER_SIZE);
+
+        if (count == 0 || count * count > max - SDT_HEADER_SIZE - sizeof(uint64_t)) {
+                return 0;
+        }
+
+        *matrix = (uint8_t *)(table + SDT_HEADER_SIZE + sizeof(uint64_t));
+
+        return count;
+}
+
+void *acpi_get_next_dmar_entry(int type, ARC_DMARIterator *it) {
+        if (type < 0 || type >= ARC_DMAR_ENTRY_TYPE_MAX || it == NULL) {
+                return NULL;
+        }
+
+        void *table = NULL;
+        size_t max = acpi_get_sdt("DMAR", &table);
+
+        if (max <= DMAR_ENTRIES_OFFSET) {
+                return NULL;
+        }
+
+        size_t i = DMAR_ENTRIES_OFFSET;
+        ARC_DMAREntry *entry = *it;
+
+        if (*it != NULL) {
+                i = ((uintptr_t)*it - (uintptr_t)table) + entry->length;
+        }
+
+        for (; i + sizeof(uint32_t) <= max; i += entry->length) {
+                entry = table + i;
+
+                if (entry->length < sizeof(uint32_t) || i + entry->length > max) {
+                        break;
+                }
+
+                if (entry->type == type) {
+                        *it = entry;
+                        return (void *)&entry->d;
+                }
+        }
+
+        *it = NULL;
+        return NULL;
+}
+
+ARC_DMARScope *acpi_get_next_dmar_scope(ARC_DMARIterator entry, ARC_DMARScope *scope) {
+        if (entry == NULL) {
+                return NULL;
+        }
+
+        size_t i = 0;
+
+        switch (entry->type) {
+                case ARC_DMAR_ENTRY_TYPE_DRHD: {
+                        i = DMAR_DRHD_SCOPES_OFFSET;
+                        break;
+                }
+
+                case ARC_DMAR_ENTRY_TYPE_RMRR: {
+                        i = DMAR_RMRR_SCOPES_OFFSET;
+                        break;
+                }
+
+                default: {
+                        return NULL;
+                }
+        }
+
+        if (scope != NULL) {
+                i = ((uintptr_t)scope - (uintptr_t)entry) + scope->length;
+        }
+
+        if (i + sizeof(ARC_DMARScope) > entry->length) {
+                return NULL;
+        }
+
+        scope = (void *)entry + i;
+
+        if (scope->length < sizeof(ARC_DMARScope) || i + scope->length > entry->length) {
+                return NULL;
+        }
+
+        return scope;
+}
+
+void *acpi_get_next_ivrs_entry(int type, ARC_IVRSIterator *it) {
+        if (it == NULL) {
+                return NULL;
+        }
+
+        void *table = NULL;
+        size_t max = acpi_get_sdt("IVRS", &table);
+
+        if (max <= IVRS_ENTRIES_OFFSET) {
+                return NULL;
+        }
+
+        size_t i = IVRS_ENTRIES_OFFSET;
+        ARC_IVRSEntry *entry = *it;
+
+        if (*it != NULL) {
+                i = ((uintptr_t)*it - (uintptr_t)table) + entry->length;
+        }
+
+        for (; i + sizeof(uint32_t) <= max; i += entry->length) {
+                entry = table + i;
+
+                if (entry->length < sizeof(uint32_t) || i + entry->length > max) {
+                        break;
+                }
+
+                if (entry->type == type) {
+                        *it = entry;
+                        return (void *)&entry->d;
+                }
+        }
+
+        *it = NULL;
+        return NULL;
+}
+
+ARC_IVRSDevice *acpi_get_next_ivrs_device(ARC_IVRSIterator entry, ARC_IVRSDevice *device) {
+        if (entry == NULL) {
+                return NULL;
+        }
+
+        size_t i = entry->type == ARC_IVRS_ENTRY_TYPE_IVHD10 ? IVRS_IVHD10_DEVICES_OFFSET : IVRS_IVHD40_DEVICES_OFFSET;
+
+        if (device != NULL) {
+                size_t length = 4;
+
+                if (device->type >= 0x80) {
+                        // HID entries carry the length of their UID last
+                        // in a fixed 22 byte part
+                        uint8_t *bytes = (uint8_t *)device;
+                        length = device->type == ARC_IVRS_DEVICE_HID ? 22 + bytes[21] : entry->length;
+                } else if (device->type >= 0x40) {
+                        length = 8;
+                }
+
+                i = ((uintptr_t)device - (uintptr_t)entry) + length;
+        }
+
+        if (i + 4 > entry->length) {
+                return NULL;
+        }
+
+        device = (void *)entry + i;
+
+        if ((device->type >= 0x40 && i + 8 > entry->length)
+            || (device->type == ARC_IVRS_DEVICE_HID && i + 22 > entry->length)) {
+                return NULL;
+        }
+
+        return device;
+}
+
+ARC_HPETTable *acpi_get_hpet() {
+        void *table = NULL;
+        size_t max = acpi_get_sdt("HPET", &table);
+
+        if (max < SDT_HEADER_SIZE + sizeof(ARC_HPETTable)) {
+                return NULL;
+        }
+
+        return table + SDT_HEADER_SIZE;
+}
+
+uint32_t numa_get_node_count() {
+        return numa_node_count == 0 ? 1 : numa_node_count;
+}
+
+uint32_t numa_get_processor_node(uint32_t id) {
+        if (numa_node_count == 0) {
+                return 0;
+        }
+
+        uint32_t low = 0;
+        uint32_t high = numa_processor_count;
+
+        while (low < high) {
+                uint32_t mid = low + (high - low) / 2;
+
+                if (numa_processors[mid].id == id) {
+                        return numa_processors[mid].node;
+                }
+
+                if (numa_processors[mid].id < id) {
+                        low = mid + 1;
+                } else {
+                        high = mid;
+                }
+        }
+
+        return ARC_NUMA_NO_NODE;
+}
+
+uint32_t numa_get_address_node(uint64_t address) {
+        if (numa_node_count == 0) {
+                return 0;
+        }
+
+        uint32_t low = 0;
+        uint32_t high = numa_range_count;
+
+        while (low < high) {
+                uint32_t mid = low + (high - low) / 2;
+                struct numa_range *range = &numa_ranges[mid];
+
+                if (address < range->base) {
+                        high = mid;
+                } else if (address >= range->end) {
+                        low = mid + 1;
+                } else {
+                        return range->node;
+                }
+        }
+
+        return ARC_NUMA_NO_NODE;
+}
+
+uint32_t numa_get_node_domain(uint32_t node) {
+        if (numa_node_count == 0) {
+                return node == 0 ? 0 : ARC_NUMA_NO_NODE;
+        }
+
+        return node < numa_node_count ? numa_domains[node] : ARC_NUMA_NO_NODE;
+}
+
+uint32_t numa_get_domain_node(uint32_t domain) {
+        if (numa_node_count == 0) {
+                return 0;
+        }
+
+        for (uint32_t i = 0; i < numa_node_count; i++) {
+                if (numa_domains[i] == domain) {
+                        return i;
+                }
+        }
+
+        return ARC_NUMA_NO_NODE;
+}
+
+uint8_t numa_get_distance(uint32_t from, uint32_t to) {
+        uint32_t count = numa_get_node_count();
+
+        if (from >= count || to >= count) {
+                return UINT8_MAX;
+        }
+
+        if (from == to) {
+                return ARC_NUMA_LOCAL_DISTANCE;
+        }
+
+        uint64_t a = numa_get_node_domain(from);
+        uint64_t b = numa_get_node_domain(to);
+
+        if (a >= numa_slit_size || b >= numa_slit_size) {
+                return ARC_NUMA_REMOTE_DISTANCE;
+        }
+
+        return numa_slit[a * numa_slit_size + b];
+}
+
+// Get the node of a proximity domain, allocating a new node the first time a
+// domain is seen. numa_domains must have room for another node
+static uint32_t numa_add_domain(uint32_t domain) {
+        for (uint32_t i = 0; i < numa_node_count; i++) {
+                if (numa_domains[i] == domain) {
+                        return i;
+                }
+        }
+
+        numa_domains[numa_node_count] = domain;
+
+        return numa_node_count++;
+}
+
+int init_numa() {
+        uint32_t processors = 0;
+        uint32_t ranges = 0;
+        ARC_SRATIterator it = NULL;
+
+        while (acpi_get_next_srat_entry(ARC_SRAT_ENTRY_TYPE_LAPIC, &it) != NULL) {
+                processors++;
+        }
+        while (acpi_get_next_srat_entry(ARC_SRAT_ENTRY_TYPE_x2APIC, &it) != NULL) {
+                processors++;
+        }
+        while (acpi_get_next_srat_entry(ARC_SRAT_ENTRY_TYPE_MEMORY, &it) != NULL) {
+                ranges++;
+        }
+
+        if (processors + ranges == 0) {
+                ARC_DEBUG(INFO, "No SRAT, assuming a single node\n");
+                return 0;
+        }
+
+        numa_domains = alloc((processors + ranges) * sizeof(*numa_domains));
+        numa_processors = alloc((processors + 1) * sizeof(*numa_processors));
+        numa_ranges = alloc((ranges + 1) * sizeof(*numa_ranges));
+
+        if (numa_domains == NULL || numa_processors == NULL || numa_ranges == NULL) {
+                ARC_DEBUG(ERR, "Failed to allocate NUMA tables\n");
+                free(numa_domains);
+                free(numa_processors);
+                free(numa_ranges);
+                numa_domains = NULL;
+                numa_processors = NULL;
+                numa_ranges = NULL;
+                return -1;
+        }
+
+        // Entries are inserted in sorted order, the tables are small enough
+        // for this to be fine and lookups can be binary searched
+        void *entry = NULL;
+        while ((entry = acpi_get_next_srat_entry(ARC_SRAT_ENTRY_TYPE_LAPIC, &it)) != NULL) {
+                ARC_SRATLapic *lapic = entry;
+
+                if ((lapic->flags & ARC_SRAT_ENABLED) == 0) {
+                        continue;
+                }
+
+                uint32_t domain = lapic->domain_low | (lapic->domain_high[0] << 8)
+                                  | (lapic->domain_high[1] << 16) | (lapic->domain_high[2] << 24);
+                struct numa_processor processor = { .id = lapic->apic_id, .node = numa_add_domain(domain) };
+
+                uint32_t i = numa_processor_count++;
+                for (; i > 0 && numa_processors[i - 1].id > processor.id; i--) {
+                        numa_processors[i] = numa_processors[i - 1];
+                }
+                numa_processors[i] = processor;
+        }
+
+        while ((entry = acpi_get_next_srat_entry(ARC_SRAT_ENTRY_TYPE_x2APIC, &it)) != NULL) {
+                ARC_SRATx2Apic *x2apic = entry;
+
+                if ((x2apic->flags & ARC_SRAT_ENABLED) == 0) {
+                        continue;
+                }
+
+                struct numa_processor processor = { .id = x2apic->x2apic_id, .node = numa_add_domain(x2apic->domain) };
+
+                uint32_t i = numa_processor_count++;
+                for (; i > 0 && numa_processors[i - 1].id > processor.id; i--) {
+                        numa_processors[i] = numa_processors[i - 1];
+                }
+                numa_processors[i] = processor;
+        }
+
+        while ((entry = acpi_get_next_srat_entry(ARC_SRAT_ENTRY_TYPE_MEMORY, &it)) != NULL) {
+                ARC_SRATMemory *memory = entry;
+
+                if ((memory->flags & ARC_SRAT_ENABLED) == 0 || memory->length == 0) {
+                        continue;
+                }
+
+                struct numa_range range = { .base = memory->base, .end = memory->base + memory->length, .node = numa_add_domain(memory->domain) };
+
+                uint32_t i = numa_range_count++;
+                for (; i > 0 && numa_ranges[i - 1].base > range.base; i--) {
+                        numa_ranges[i] = numa_ranges[i - 1];
+                }
+                numa_ranges[i] = range;
+        }
+
+        numa_slit_size = acpi_get_slit(&numa_slit);
+
+        ARC_DEBUG(INFO, "%d NUMA nodes, %d processors, %d memory ranges, %s SLIT\n", numa_node_count, numa_processor_count,
+                  numa_range_count, numa_slit_size > 0 ? "with" : "without");
+
+        return 0;
+}
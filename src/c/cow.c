@@ -0,0 +1,143 @@
+/**
+ * @file cow.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * Count the mappings sharing frames that were cloned copy-on-write. Frames
+ * are only tracked while shared, an untracked frame has a single owner.
+*/
+#include "arch/pager.h"
+#include "global.h"
+#include "mm/allocator.h"
+
+#define FRAME_BUCKET_BITS 10
+#define FRAME_BUCKETS (1 << FRAME_BUCKET_BITS)
+#define FRAME_SHIFT 12
+
+struct frame_share {
+	struct frame_share *next;
+	uintptr_t frame;
+	uint32_t count;
+};
+
+struct frame_bucket {
+	struct frame_share *shares;
+	uint32_t lock;
+};
+
+static struct frame_bucket frame_buckets[FRAME_BUCKETS] = { 0 };
+
+static struct frame_bucket *frame_lock(uintptr_t frame) {
+	// Spread consecutive frames, which are usually shared together
+	struct frame_bucket *bucket = &frame_buckets[((uint64_t)frame * 0x9E3779B97F4A7C15) >> (64 - FRAME_BUCKET_BITS)];
+
+	while (__atomic_exchange_n(&bucket->lock, 1, __ATOMIC_ACQUIRE) != 0) {
+#ifdef ARC_TARGET_ARCH_X86_64
+		__builtin_ia32_pause();
+#endif
+	}
+
+	return bucket;
+}
+
+static void frame_unlock(struct frame_bucket *bucket) {
+	__atomic_store_n(&bucket->lock, 0, __ATOMIC_RELEASE);
+}
+
+int pager_share_frame(uintptr_t physical) {
+	uintptr_t frame = physical >> FRAME_SHIFT;
+	struct frame_bucket *bucket = frame_lock(frame);
+
+	for (struct frame_share *share = bucket->shares; share != NULL; share = share->next) {
+		if (share->frame == frame) {
+			share->count++;
+			frame_unlock(bucket);
+			return 0;
+		}
+	}
+
+	struct frame_share *share = alloc(sizeof(*share));
+
+	if (share == NULL) {
+		frame_unlock(bucket);
+		ARC_DEBUG(ERR, "Failed to track share of frame 0x%"PRIx64"\n", (uint64_t)physical);
+		return -1;
+	}
+
+	// The owner and the new mapping
+	share->frame = frame;
+	share->count = 2;
+	share->next = bucket->shares;
+	bucket->shares = share;
+
+	frame_unlock(bucket);
+
+	return 0;
+}
+
+int pager_unshare_frame(uintptr_t physical) {
+	uintptr_t frame = physical >> FRAME_SHIFT;
+	struct frame_bucket *bucket = frame_lock(frame);
+	struct frame_share **link = &bucket->shares;
+
+	while (*link != NULL && (*link)->frame != frame) {
+		link = &(*link)->next;
+	}
+
+	struct frame_share *share = *link;
+
+	if (share == NULL) {
+		frame_unlock(bucket);
+		return 0;
+	}
+
+	uint32_t count = --share->count;
+
+	if (count == 1) {
+		*link = share->next;
+	}
+
+	frame_unlock(bucket);
+
+	if (count == 1) {
+		free(share);
+	}
+
+	return count;
+}
+
+uint32_t pager_get_frame_shares(uintptr_t physical) {
+	uintptr_t frame = physical >> FRAME_SHIFT;
+	struct frame_bucket *bucket = frame_lock(frame);
+	uint32_t count = 1;
+
+	for (struct frame_share *share = bucket->shares; share != NULL; share = share->next) {
+		if (share->frame == frame) {
+			count = share->count;
+			break;
+		}
+	}
+
+	frame_unlock(bucket);
+
+	return count;
+}
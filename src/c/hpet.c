@@ -0,0 +1,372 @@
+/**
+ * @file hpet.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Driver for the High Precision Event Timer.
+*/
+#include "arch/acpi/table.h"
+#include "arch/hpet.h"
+#include "arch/info.h"
+#include "arch/interrupt.h"
+#include "arch/pager.h"
+#include "arch/smp.h"
+#include "global.h"
+
+#define HPET_REG_CAPABILITIES 0x000
+#define HPET_REG_CONFIG       0x010
+#define HPET_REG_STATUS       0x020
+#define HPET_REG_COUNTER      0x0F0
+#define HPET_REG_TIMER_CONFIG(__n)     (0x100 + (__n) * 0x20)
+#define HPET_REG_TIMER_COMPARATOR(__n) (0x108 + (__n) * 0x20)
+
+#define HPET_CAP_TIMERS(__cap) ((((__cap) >> 8) & 0x1F) + 1)
+#define HPET_CAP_64BIT         (1 << 13)
+#define HPET_CAP_PERIOD(__cap) ((uint32_t)((__cap) >> 32))
+// Largest period allowed by the specification, 100ns
+#define HPET_MAX_PERIOD 100000000
+
+#define HPET_CONFIG_ENABLE (1 << 0)
+#define HPET_CONFIG_LEGACY (1 << 1)
+
+#define HPET_TIMER_LEVEL     (1 << 1)
+#define HPET_TIMER_ENABLE    (1 << 2)
+#define HPET_TIMER_PERIODIC  (1 << 3)
+#define HPET_TIMER_64BIT     (1 << 5)
+#define HPET_TIMER_32BIT     (1 << 8)
+#define HPET_TIMER_ROUTE_SHIFT 9
+#define HPET_TIMER_ROUTE_MASK  (0x1F << HPET_TIMER_ROUTE_SHIFT)
+#define HPET_TIMER_FSB       (1 << 14)
+#define HPET_TIMER_ROUTES(__config) ((uint32_t)((__config) >> 32))
+
+// Size of the register block
+#define HPET_MAP_SIZE 0x1000
+
+#define HPET_FS_PER_NS 1000000
+
+#define HPET_CALIBRATION_ROUNDS 5
+#define HPET_CALIBRATION_NS 10000000
+// Number of reads a sample is the tightest of
+#define HPET_CALIBRATION_SAMPLES 8
+
+static volatile uint64_t *hpet_base = NULL;
+static uint32_t hpet_period = 0;
+static uint32_t hpet_timers = 0;
+static bool hpet_64bit = false;
+// Last value returned by hpet_read, used to extend 32-bit counters
+static uint64_t hpet_last = 0;
+static uint64_t hpet_epoch = 0;
+
+static inline void hpet_relax() {
+#ifdef ARC_TARGET_ARCH_X86_64
+	__builtin_ia32_pause();
+#endif
+}
+
+static uint64_t hpet_reg_read(uint32_t reg) {
+	return hpet_base[reg / sizeof(uint64_t)];
+}
+
+static void hpet_reg_write(uint32_t reg, uint64_t value) {
+	hpet_base[reg / sizeof(uint64_t)] = value;
+}
+
+bool hpet_present() {
+	return hpet_base != NULL;
+}
+
+uint64_t hpet_read() {
+	if (hpet_base == NULL) {
+		return 0;
+	}
+
+	if (hpet_64bit) {
+		return hpet_reg_read(HPET_REG_COUNTER);
+	}
+
+	uint64_t last = __atomic_load_n(&hpet_last, __ATOMIC_RELAXED);
+	uint64_t now = 0;
+
+	do {
+		uint32_t low = (uint32_t)hpet_reg_read(HPET_REG_COUNTER);
+		now = (last & ~(uint64_t)UINT32_MAX) | low;
+
+		if (now < last) {
+			now += (uint64_t)UINT32_MAX + 1;
+		}
+	} while (!__atomic_compare_exchange_n(&hpet_last, &last, now, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	return now;
+}
+
+uint32_t hpet_get_period() {
+	return hpet_period;
+}
+
+uint64_t hpet_ticks_to_ns(uint64_t ticks) {
+	// Split to avoid overflowing after a few hours worth of ticks
+	return (ticks / HPET_FS_PER_NS) * hpet_period + ((ticks % HPET_FS_PER_NS) * hpet_period) / HPET_FS_PER_NS;
+}
+
+static uint64_t hpet_ns_to_ticks(uint64_t ns) {
+	if (hpet_period == 0) {
+		return 0;
+	}
+
+	return (ns / hpet_period) * HPET_FS_PER_NS + ((ns % hpet_period) * HPET_FS_PER_NS) / hpet_period;
+}
+
+uint64_t hpet_get_ns() {
+	return hpet_ticks_to_ns(hpet_read() - hpet_epoch);
+}
+
+uint32_t hpet_get_timer_count() {
+	return hpet_timers;
+}
+
+int hpet_init_event(uint32_t timer, void (*handler)(), uint32_t *gsi) {
+	if (hpet_base == NULL || timer >= hpet_timers || handler == NULL) {
+		return -1;
+	}
+
+	uint64_t config = hpet_reg_read(HPET_REG_TIMER_CONFIG(timer));
+	uint32_t routes = HPET_TIMER_ROUTES(config);
+
+	if (routes == 0) {
+		ARC_DEBUG(ERR, "HPET timer %d cannot be routed to the I/O APIC\n", timer);
+		return -1;
+	}
+
+	// Inputs below 16 are shared with ISA devices
+	uint32_t route = (routes & ~0xFFFF) != 0 ? __builtin_ctz(routes & ~0xFFFF) : __builtin_ctz(routes);
+	config &= ~(HPET_TIMER_LEVEL | HPET_TIMER_ENABLE | HPET_TIMER_PERIODIC | HPET_TIMER_ROUTE_MASK | HPET_TIMER_FSB);
+	config |= route << HPET_TIMER_ROUTE_SHIFT;
+	hpet_reg_write(HPET_REG_TIMER_CONFIG(timer), config);
+
+	if ((hpet_reg_read(HPET_REG_TIMER_CONFIG(timer)) & HPET_TIMER_ROUTE_MASK) != route << HPET_TIMER_ROUTE_SHIFT) {
+		ARC_DEBUG(ERR, "HPET timer %d did not accept route to GSI %d\n", timer, route);
+		return -1;
+	}
+
+	int vector = interrupt_alloc_vector();
+
+	if (vector < 0) {
+		ARC_DEBUG(ERR, "No free vector for HPET timer %d\n", timer);
+		return -1;
+	}
+
+	// Edge triggered, active high
+	if (interrupt_set(NULL, vector, handler, true) != 0
+	    || interrupt_map_gsi(route, vector, smp_get_processor_id(), 0) != 0) {
+		ARC_DEBUG(ERR, "Failed to install HPET timer %d on GSI %d\n", timer, route);
+		interrupt_free_vector(vector);
+		return -1;
+	}
+
+	if (gsi != NULL) {
+		*gsi = route;
+	}
+
+	return 0;
+}
+
+int hpet_arm_event(uint32_t timer, uint64_t ns) {
+	if (hpet_base == NULL || timer >= hpet_timers) {
+		return -1;
+	}
+
+	uint64_t config = hpet_reg_read(HPET_REG_TIMER_CONFIG(timer));
+	bool wide = hpet_64bit && (config & HPET_TIMER_64BIT);
+	uint64_t delta = hpet_ns_to_ticks(ns);
+
+	if (delta == 0) {
+		delta = 1;
+	}
+
+	if (!wide && delta > UINT32_MAX) {
+		ARC_DEBUG(ERR, "HPET timer %d cannot reach %lu ns\n", timer, ns);
+		return -1;
+	}
+
+	uint64_t start = hpet_read();
+	uint64_t target = start + delta;
+
+	hpet_reg_write(HPET_REG_TIMER_COMPARATOR(timer), wide ? target : (uint32_t)target);
+	hpet_reg_write(HPET_REG_TIMER_CONFIG(timer), config | HPET_TIMER_ENABLE);
+
+	// The comparator only matches on equality, so a deadline that passed
+	// while it was being written is missed
+	if (hpet_read() - start >= delta) {
+		return 1;
+	}
+
+	return 0;
+}
+
+int hpet_disarm_event(uint32_t timer) {
+	if (hpet_base == NULL || timer >= hpet_timers) {
+		return -1;
+	}
+
+	uint64_t config = hpet_reg_read(HPET_REG_TIMER_CONFIG(timer));
+	hpet_reg_write(HPET_REG_TIMER_CONFIG(timer), config & ~HPET_TIMER_ENABLE);
+
+	return 0;
+}
+
+// Take the cycle count between two counter reads, the tightest pair out of a
+// few bounds how far the cycle count is from the counter value
+static uint64_t hpet_calibration_sample(uint64_t *ticks, uint64_t *cycles) {
+	uint64_t window = UINT64_MAX;
+
+	for (int i = 0; i < HPET_CALIBRATION_SAMPLES; i++) {
+		uint64_t before = hpet_read();
+		uint64_t now = arch_get_cycles();
+		uint64_t after = hpet_read();
+
+		if (after - before < window) {
+			window = after - before;
+			*ticks = before + window / 2;
+			*cycles = now;
+		}
+	}
+
+	return window;
+}
+
+int hpet_calibrate_cycles(ARC_HPETCalibration *out) {
+	if (hpet_base == NULL || out == NULL) {
+		return -1;
+	}
+
+	uint64_t interval = hpet_ns_to_ticks(HPET_CALIBRATION_NS);
+	ARC_HPETCalibration best = { .hz = 0, .error_hz = UINT64_MAX };
+
+	for (int i = 0; i < HPET_CALIBRATION_ROUNDS; i++) {
+		uint64_t start_ticks = 0, start_cycles = 0;
+		uint64_t end_ticks = 0, end_cycles = 0;
+
+		uint64_t start_window = hpet_calibration_sample(&start_ticks, &start_cycles);
+
+		while (hpet_read() - start_ticks < interval) {
+			hpet_relax();
+		}
+
+		uint64_t end_window = hpet_calibration_sample(&end_ticks, &end_cycles);
+
+		uint64_t ns = hpet_ticks_to_ns(end_ticks - start_ticks);
+
+		if (ns == 0 || end_cycles <= start_cycles) {
+			continue;
+		}
+
+		uint64_t hz = ((end_cycles - start_cycles) * 1000000000) / ns;
+		// Each endpoint is within half its window plus a tick of the
+		// counter value it was assigned
+		uint64_t error_ns = hpet_ticks_to_ns((start_window + end_window) / 2 + 2);
+		uint64_t error_hz = (hz * error_ns) / ns + 1;
+
+		if (error_hz < best.error_hz) {
+			best.hz = hz;
+			best.error_hz = error_hz;
+			best.interval_ns = ns;
+		}
+	}
+
+	if (best.hz == 0) {
+		ARC_DEBUG(ERR, "Failed to calibrate cycle counter\n");
+		return -1;
+	}
+
+	*out = best;
+
+	return 0;
+}
+
+int init_hpet() {
+	ARC_HPETTable *table = acpi_get_hpet();
+
+	if (table == NULL) {
+		ARC_DEBUG(INFO, "No HPET\n");
+		return -1;
+	}
+
+	if (table->base.space_id != ARC_ACPI_GAS_SPACE_MEMORY || table->base.address == 0) {
+		ARC_DEBUG(ERR, "HPET is not memory mapped\n");
+		return -1;
+	}
+
+	uint64_t base = table->base.address;
+	uint32_t attributes = (ARC_PAGER_PAT_UC << ARC_PAGER_PAT) | (1 << ARC_PAGER_NX) | (1 << ARC_PAGER_RW);
+
+	// The registers may already be mapped as part of the HHDM, in which
+	// case they are remapped unless they are already uncached
+	ARC_PagerTranslation translation = { 0 };
+	bool mapped = pager_translate((void *)Arc_KernelPageTables, ARC_PHYS_TO_HHDM(base), &translation) == 0;
+
+	if (mapped && ((translation.attributes >> ARC_PAGER_PAT) & 0b111) != ARC_PAGER_PAT_UC) {
+		attributes |= 1 << ARC_PAGER_OVW;
+		mapped = false;
+	}
+
+	if (!mapped && pager_map((void *)Arc_KernelPageTables, ARC_PHYS_TO_HHDM(base), base, HPET_MAP_SIZE, attributes) != 0) {
+		ARC_DEBUG(ERR, "Failed to map HPET at 0x%"PRIx64"\n", base);
+		return -1;
+	}
+
+	hpet_base = (volatile uint64_t *)ARC_PHYS_TO_HHDM(base);
+
+	uint64_t capabilities = hpet_reg_read(HPET_REG_CAPABILITIES);
+	uint32_t period = HPET_CAP_PERIOD(capabilities);
+
+	if (period == 0 || period > HPET_MAX_PERIOD) {
+		ARC_DEBUG(ERR, "HPET has invalid period of %d fs\n", period);
+		hpet_base = NULL;
+		return -1;
+	}
+
+	hpet_period = period;
+	hpet_timers = HPET_CAP_TIMERS(capabilities);
+	hpet_64bit = (capabilities & HPET_CAP_64BIT) != 0;
+
+	// Disable every comparator until it is asked for
+	for (uint32_t i = 0; i < hpet_timers; i++) {
+		uint64_t config = hpet_reg_read(HPET_REG_TIMER_CONFIG(i));
+		hpet_reg_write(HPET_REG_TIMER_CONFIG(i), config & ~(HPET_TIMER_ENABLE | HPET_TIMER_PERIODIC));
+	}
+
+	uint64_t config = hpet_reg_read(HPET_REG_CONFIG);
+	hpet_reg_write(HPET_REG_CONFIG, (config & ~HPET_CONFIG_LEGACY) | HPET_CONFIG_ENABLE);
+
+	hpet_last = hpet_64bit ? 0 : (uint32_t)hpet_reg_read(HPET_REG_COUNTER);
+	hpet_epoch = hpet_read();
+
+	ARC_DEBUG(INFO, "HPET at 0x%"PRIx64", %d fs period, %d %d-bit timers\n", base, hpet_period, hpet_timers, hpet_64bit ? 64 : 32);
+
+	ARC_HPETCalibration calibration = { 0 };
+	if (hpet_calibrate_cycles(&calibration) == 0) {
+		ARC_DEBUG(INFO, "Cycle counter at %lu +/- %lu Hz\n", calibration.hz, calibration.error_hz);
+	}
+
+	return 0;
+}
@@ -30,6 +30,13 @@
 #include <stdint.h>
 #include <stddef.h>
 
+// Least severe uACPI message that is logged, messages above this level are
+// dropped before being formatted (1: Error, 2: Warn, 3: Info, 4: Trace,
+// 5: Debug)
+#ifndef ARC_ACPI_LOG_LEVEL
+#define ARC_ACPI_LOG_LEVEL 3
+#endif
+
 typedef struct ARC_ACPIDevIO {
         struct ARC_ACPIDevIO *next;
         uint32_t base;
@@ -52,8 +59,121 @@ typedef struct ARC_ACPIDevIRQ {
 typedef struct ARC_ACPIDevInfo {
         struct ARC_ACPIDevIO *io;
         struct ARC_ACPIDevIRQ *irq;
+        // NUMA node the device is attached to, ARC_NUMA_NO_NODE if unknown
+        uint32_t numa_node;
 } ARC_ACPIDevInfo;
 
+typedef struct ARC_ACPIMutexStats {
+        uint64_t contended;
+        uint64_t spun;     // Acquired after spinning on a running owner
+        uint64_t blocked;  // Had to wait past the spinning phase
+        uint64_t timeouts;
+} ARC_ACPIMutexStats;
+
+// Number of size classes in the pool backing uACPI allocations
+#define ARC_ACPI_POOL_CLASSES 13
+
+typedef struct ARC_ACPIPoolClassStats {
+        uint32_t size; // 0 for allocations larger than any class
+        uint64_t allocations;
+        uint64_t frees;
+        uint64_t in_use;
+        uint64_t peak;
+} ARC_ACPIPoolClassStats;
+
+typedef struct ARC_ACPIPoolStats {
+        // The last entry accounts for allocations larger than any class
+        ARC_ACPIPoolClassStats classes[ARC_ACPI_POOL_CLASSES + 1];
+        uint64_t arena_size;
+        uint64_t bytes;
+        uint64_t peak_bytes;
+} ARC_ACPIPoolStats;
+
+/**
+ * Get the NUMA node of a PCI host bridge.
+ *
+ * Host bridges are discovered, and their _PXM evaluated, by init_acpi.
+ *
+ * @param uint16_t segment - Segment group of the host bridge.
+ * @param uint8_t bus - Bus number the host bridge decodes.
+ * @return the node of the host bridge, ARC_NUMA_NO_NODE if it is unknown.
+ * */
+uint32_t acpi_get_pci_root_node(uint16_t segment, uint8_t bus);
+
+/**
+ * Find a namespace node by its absolute path, through uACPI.
+ *
+ * No reference is taken for the caller. As with uacpi_namespace_node_find,
+ * the node stays valid until the table defining it is unloaded or the
+ * namespace is reset, nothing held by this module can release it earlier.
+ *
+ * @return the node, NULL if there is none.
+ * */
+struct uacpi_namespace_node *acpi_find_node(const char *path);
+/**
+ * Find a device node by its _HID and _UID.
+ *
+ * Devices are cached by their IDs along with their absolute path as they are
+ * discovered by init_acpi, and the node is found again from the path on every
+ * call. The node is valid for as long as with acpi_find_node.
+ *
+ * @param const char *uid - NULL for devices without a _UID.
+ * */
+struct uacpi_namespace_node *acpi_find_node_by_id(const char *hid, const char *uid);
+/**
+ * Drop cached device paths, the cache is rebuilt on next lookup.
+ *
+ * Called whenever a table is installed, and when a lookup finds a cached
+ * device was removed from the namespace. Anything removing nodes from the
+ * namespace should call it, so that later lookups do not miss devices that
+ * moved.
+ * */
+void acpi_invalidate_node_cache();
+
+/**
+ * Get contention counters accumulated over all uACPI mutexes.
+ * */
+int acpi_get_mutex_stats(ARC_ACPIMutexStats *out);
+
+/**
+ * Get usage of the pool backing uACPI allocations.
+ * */
+int acpi_get_pool_stats(ARC_ACPIPoolStats *out);
+
+/**
+ * Return the memory of the pool backing uACPI allocations.
+ *
+ * The pool acts as an arena for the lifetime of the uACPI state, so this
+ * fails unless every object has been freed (i.e. after uacpi_state_reset).
+ * */
+int acpi_release_pool();
+
+/**
+ * Run the bottom half of the SCI and any work deferred by uACPI.
+ *
+ * The hard IRQ handler only acknowledges the SCI, masks it and wakes the
+ * worker, the SCI is unmasked again once its handler has run. This is
+ * expected to be called in a loop from a dedicated kernel thread. When there
+ * is nothing to handle, it parks the thread with smp_park until the SCI fires
+ * or work is scheduled, and returns 0.
+ *
+ * The first caller becomes the worker uACPI waits on for deferred work to
+ * complete. Until then, the wait runs the work itself.
+ *
+ * @return the number of items that were handled.
+ * */
+int acpi_handle_events();
+
+/**
+ * Print messages uACPI has logged since the last flush.
+ *
+ * Messages are formatted into per-processor rings and are only printed
+ * by this function, which is called as part of acpi_handle_events and once
+ * init_acpi is done.
+ *
+ * @return the number of messages printed.
+ * */
+int acpi_flush_log();
 int init_acpi();
 
 #endif
@@ -75,11 +75,19 @@ typedef struct ARC_MADT_NMI {
         uint32_t gsi;
 } __attribute__((packed)) ARC_MADT_NMI;
 
+typedef struct ARC_MADTx2Apic {
+        uint16_t resv0;
+        uint32_t id;
+        uint32_t flags;
+        uint32_t uid;
+} __attribute__((packed)) ARC_MADTx2Apic;
+
 typedef struct ARC_MADTEntry {
         uint8_t type;
         uint8_t length;
         union {
                 ARC_MADTLapic lapic;
+                ARC_MADTx2Apic x2apic;
                 ARC_MADTIOApic ioapic;
                 ARC_MADT_ISO interrupt_source_override;
                 ARC_MADT_NMI nmi;
@@ -94,10 +102,284 @@ typedef struct ARC_MCFGEntry {
 	uint32_t resv0;
 } __attribute__((packed)) ARC_MCFGEntry;
 
+enum {
+        ARC_SRAT_ENTRY_TYPE_LAPIC  = 0x00,
+        ARC_SRAT_ENTRY_TYPE_MEMORY = 0x01,
+        ARC_SRAT_ENTRY_TYPE_x2APIC = 0x02,
+        ARC_SRAT_ENTRY_TYPE_MAX,
+};
+
+// Bit 0 of the flags field of all SRAT entries
+#define ARC_SRAT_ENABLED 1
+
+typedef struct ARC_SRATLapic {
+        uint8_t domain_low;
+        uint8_t apic_id;
+        uint32_t flags;
+        uint8_t sapic_eid;
+        uint8_t domain_high[3];
+        uint32_t clock_domain;
+} __attribute__((packed)) ARC_SRATLapic;
+
+typedef struct ARC_SRATMemory {
+        uint32_t domain;
+        uint16_t resv0;
+        uint64_t base;
+        uint64_t length;
+        uint32_t resv1;
+        uint32_t flags;
+        uint64_t resv2;
+} __attribute__((packed)) ARC_SRATMemory;
+
+typedef struct ARC_SRATx2Apic {
+        uint16_t resv0;
+        uint32_t domain;
+        uint32_t x2apic_id;
+        uint32_t flags;
+        uint32_t clock_domain;
+        uint32_t resv1;
+} __attribute__((packed)) ARC_SRATx2Apic;
+
+typedef struct ARC_SRATEntry {
+        uint8_t type;
+        uint8_t length;
+        union {
+                ARC_SRATLapic lapic;
+                ARC_SRATMemory memory;
+                ARC_SRATx2Apic x2apic;
+        } d;
+} __attribute__((packed)) ARC_SRATEntry;
+
+enum {
+        ARC_PPTT_ENTRY_TYPE_PROCESSOR = 0x00,
+        ARC_PPTT_ENTRY_TYPE_CACHE     = 0x01,
+        ARC_PPTT_ENTRY_TYPE_ID        = 0x02,
+        ARC_PPTT_ENTRY_TYPE_MAX,
+};
+
+// Flags of processor hierarchy nodes
+#define ARC_PPTT_PROCESSOR_PACKAGE  (1 << 0)
+#define ARC_PPTT_PROCESSOR_ID_VALID (1 << 1)
+#define ARC_PPTT_PROCESSOR_THREAD   (1 << 2)
+#define ARC_PPTT_PROCESSOR_LEAF     (1 << 3)
+
+// 0: Data, 1: Instruction, 2 or 3: Unified
+#define ARC_PPTT_CACHE_TYPE(__attributes) (((__attributes) >> 2) & 0b11)
+
+// NOTE: Processor hierarchy nodes are followed by private_count offsets of
+//       the cache nodes describing their private resources. All offsets are
+//       from the start of the table, including its header
+typedef struct ARC_PPTTProcessor {
+        uint32_t flags;
+        uint32_t parent;
+        uint32_t acpi_id;
+        uint32_t private_count;
+} __attribute__((packed)) ARC_PPTTProcessor;
+
+typedef struct ARC_PPTTCache {
+        uint32_t flags;
+        uint32_t next_level;
+        uint32_t size;
+        uint32_t sets;
+        uint8_t associativity;
+        uint8_t attributes;
+        uint16_t line_size;
+} __attribute__((packed)) ARC_PPTTCache;
+
+typedef struct ARC_PPTTEntry {
+        uint8_t type;
+        uint8_t length;
+        uint16_t resv0;
+        union {
+                ARC_PPTTProcessor processor;
+                ARC_PPTTCache cache;
+        } d;
+} __attribute__((packed)) ARC_PPTTEntry;
+
+// Generic address structure
+typedef struct ARC_ACPIGas {
+        uint8_t space_id;
+        uint8_t bit_width;
+        uint8_t bit_offset;
+        uint8_t access_size;
+        uint64_t address;
+} __attribute__((packed)) ARC_ACPIGas;
+
+#define ARC_ACPI_GAS_SPACE_MEMORY 0
+#define ARC_ACPI_GAS_SPACE_IO     1
+
+typedef struct ARC_HPETTable {
+        uint32_t block_id;
+        ARC_ACPIGas base;
+        uint8_t number;
+        uint16_t min_tick;
+        uint8_t protection;
+} __attribute__((packed)) ARC_HPETTable;
+
+enum {
+        ARC_DMAR_ENTRY_TYPE_DRHD = 0x00,
+        ARC_DMAR_ENTRY_TYPE_RMRR = 0x01,
+        ARC_DMAR_ENTRY_TYPE_ATSR = 0x02,
+        ARC_DMAR_ENTRY_TYPE_RHSA = 0x03,
+        ARC_DMAR_ENTRY_TYPE_ANDD = 0x04,
+        ARC_DMAR_ENTRY_TYPE_SATC = 0x05,
+        ARC_DMAR_ENTRY_TYPE_MAX,
+};
+
+enum {
+        ARC_DMAR_SCOPE_TYPE_ENDPOINT  = 0x01,
+        ARC_DMAR_SCOPE_TYPE_BRIDGE    = 0x02,
+        ARC_DMAR_SCOPE_TYPE_IOAPIC    = 0x03,
+        ARC_DMAR_SCOPE_TYPE_HPET      = 0x04,
+        ARC_DMAR_SCOPE_TYPE_NAMESPACE = 0x05,
+};
+
+// The unit translates every device of its segment that is not listed under
+// another unit
+#define ARC_DMAR_DRHD_INCLUDE_PCI_ALL (1 << 0)
+
+typedef struct ARC_DMARDrhd {
+        uint8_t flags;
+        uint8_t size;
+        uint16_t segment;
+        uint64_t base;
+} __attribute__((packed)) ARC_DMARDrhd;
+
+typedef struct ARC_DMARRmrr {
+        uint16_t resv0;
+        uint16_t segment;
+        uint64_t base;
+        uint64_t limit;
+} __attribute__((packed)) ARC_DMARRmrr;
+
+// Followed by (length - 6) / 2 device, function pairs leading from
+// start_bus to the device through bridges
+typedef struct ARC_DMARScope {
+        uint8_t type;
+        uint8_t length;
+        uint8_t flags;
+        uint8_t resv0;
+        uint8_t enumeration_id;
+        uint8_t start_bus;
+        struct {
+                uint8_t device;
+                uint8_t function;
+        } __attribute__((packed)) path[];
+} __attribute__((packed)) ARC_DMARScope;
+
+typedef struct ARC_DMAREntry {
+        uint16_t type;
+        uint16_t length;
+        union {
+                ARC_DMARDrhd drhd;
+                ARC_DMARRmrr rmrr;
+        } d;
+} __attribute__((packed)) ARC_DMAREntry;
+
+enum {
+        ARC_IVRS_ENTRY_TYPE_IVHD10 = 0x10,
+        ARC_IVRS_ENTRY_TYPE_IVHD11 = 0x11,
+        ARC_IVRS_ENTRY_TYPE_IVMD20 = 0x20,
+        ARC_IVRS_ENTRY_TYPE_IVMD21 = 0x21,
+        ARC_IVRS_ENTRY_TYPE_IVMD22 = 0x22,
+        ARC_IVRS_ENTRY_TYPE_IVHD40 = 0x40,
+};
+
+// Device entries of an IVHD, entries of types below 0x40 are 4 bytes long,
+// below 0x80 8 bytes long, variable beyond
+enum {
+        ARC_IVRS_DEVICE_PAD         = 0x00,
+        ARC_IVRS_DEVICE_ALL         = 0x01,
+        ARC_IVRS_DEVICE_SELECT      = 0x02,
+        ARC_IVRS_DEVICE_RANGE_START = 0x03,
+        ARC_IVRS_DEVICE_RANGE_END   = 0x04,
+        ARC_IVRS_DEVICE_ALIAS       = 0x42,
+        ARC_IVRS_DEVICE_ALIAS_START = 0x43,
+        ARC_IVRS_DEVICE_EXT         = 0x46,
+        ARC_IVRS_DEVICE_EXT_START   = 0x47,
+        ARC_IVRS_DEVICE_SPECIAL     = 0x48,
+        ARC_IVRS_DEVICE_HID         = 0xF0,
+};
+
+typedef struct ARC_IVRSIvhd {
+        uint16_t device_id;
+        uint16_t capability;
+        uint64_t base;
+        uint16_t segment;
+        uint16_t info;
+        uint32_t features;
+} __attribute__((packed)) ARC_IVRSIvhd;
+
+typedef struct ARC_IVRSDevice {
+        uint8_t type;
+        uint16_t id;
+        uint8_t data;
+        // Entries of 8 bytes
+        uint8_t resv0;
+        // Device requests of the range are tagged with (alias types)
+        uint16_t source;
+        uint8_t resv1;
+} __attribute__((packed)) ARC_IVRSDevice;
+
+typedef struct ARC_IVRSEntry {
+        uint8_t type;
+        uint8_t flags;
+        uint16_t length;
+        union {
+                ARC_IVRSIvhd ivhd;
+        } d;
+} __attribute__((packed)) ARC_IVRSEntry;
+
 typedef ARC_MADTEntry * ARC_MADTIterator;
 typedef ARC_MCFGEntry * ARC_MCFGIterator;
+typedef ARC_SRATEntry * ARC_SRATIterator;
+typedef ARC_PPTTEntry * ARC_PPTTIterator;
+typedef ARC_DMAREntry * ARC_DMARIterator;
+typedef ARC_IVRSEntry * ARC_IVRSIterator;
 
 void *acpi_get_next_madt_entry(int type, ARC_MADTIterator *it);
 int acpi_get_next_mcfg_entry(ARC_MCFGIterator *it);
+void *acpi_get_next_srat_entry(int type, ARC_SRATIterator *it);
+void *acpi_get_next_pptt_entry(int type, ARC_PPTTIterator *it);
+/**
+ * Get a PPTT entry by the offset other entries use to refer to it.
+ * */
+ARC_PPTTEntry *acpi_get_pptt_entry(uint32_t offset);
+uint32_t acpi_get_pptt_offset(ARC_PPTTEntry *entry);
+void *acpi_get_next_dmar_entry(int type, ARC_DMARIterator *it);
+/**
+ * Get the next device scope of a DRHD or RMRR.
+ *
+ * @param ARC_DMARIterator entry - The DRHD or RMRR, as set by
+ * acpi_get_next_dmar_entry.
+ * @param ARC_DMARScope *scope - The previous scope, NULL for the first.
+ * */
+ARC_DMARScope *acpi_get_next_dmar_scope(ARC_DMARIterator entry, ARC_DMARScope *scope);
+void *acpi_get_next_ivrs_entry(int type, ARC_IVRSIterator *it);
+/**
+ * Get the next device entry of an IVHD.
+ *
+ * @param ARC_IVRSIterator entry - The IVHD, as set by acpi_get_next_ivrs_entry.
+ * @param ARC_IVRSDevice *device - The previous device entry, NULL for the
+ * first.
+ * */
+ARC_IVRSDevice *acpi_get_next_ivrs_device(ARC_IVRSIterator entry, ARC_IVRSDevice *device);
+
+/**
+ * Get the SLIT distance matrix.
+ *
+ * @param uint8_t **matrix - Set to the row major matrix of distances between
+ * proximity domains.
+ * @return the number of proximity domains in the matrix, 0 if there is no
+ * SLIT.
+ * */
+uint64_t acpi_get_slit(uint8_t **matrix);
+/**
+ * Get the description of the first HPET block.
+ *
+ * @return a pointer to the fields following the table header, NULL if there
+ * is no HPET table.
+ * */
+ARC_HPETTable *acpi_get_hpet();
 
 #endif
@@ -41,6 +41,10 @@
 //       context information that may change from process to process as
 //       ARC_Context
 
+// NOTE: ARC_Context should hold the page tables of the thread, which are
+//       loaded with the tag and flush smp_tlb_switch returns for them so
+//       that translations survive switches between address spaces
+
 // NOTE: The architecture specific context.h header file should define
 //       macros to, in assembly, push all and pop all registers in the
 //       order defined in ARC_Registers
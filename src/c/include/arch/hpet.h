@@ -0,0 +1,90 @@
+/**
+ * @file hpet.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Driver for the High Precision Event Timer, used as the reference clock of the
+ * kernel and to calibrate arch_get_cycles.
+*/
+#ifndef ARC_ARCH_HPET_H
+#define ARC_ARCH_HPET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct ARC_HPETCalibration {
+        // Frequency of arch_get_cycles in Hz
+        uint64_t hz;
+        // The actual frequency is within hz +/- error_hz, not accounting for
+        // the tolerance of the HPET's own oscillator
+        uint64_t error_hz;
+        // Length of the measurement the estimate was taken from
+        uint64_t interval_ns;
+} ARC_HPETCalibration;
+
+bool hpet_present();
+/**
+ * Read the main counter.
+ *
+ * 32-bit counters are extended to 64 bits, which requires the counter to be
+ * read at least once per wrap around (about 5 minutes at 14.318 MHz).
+ * */
+uint64_t hpet_read();
+// Period of the main counter in femtoseconds
+uint32_t hpet_get_period();
+uint64_t hpet_ticks_to_ns(uint64_t ticks);
+// Monotonic time since the HPET was initialized
+uint64_t hpet_get_ns();
+uint32_t hpet_get_timer_count();
+/**
+ * Route a comparator to an I/O APIC input for one-shot events.
+ *
+ * The comparator is routed edge triggered to the lowest GSI it supports
+ * outside of the ISA range where possible. The GSI is delivered to the
+ * current processor on a vector from interrupt_alloc_vector, which is bound
+ * to handler.
+ *
+ * @param uint32_t timer - Index of the comparator, 0 is best left to the
+ * legacy replacement route.
+ * @param void (*handler)() - ARC_NAME_IRQ of the handler, which must call
+ * interrupt_end.
+ * @param uint32_t *gsi - Set to the chosen GSI if not NULL.
+ * @return zero on success.
+ * */
+int hpet_init_event(uint32_t timer, void (*handler)(), uint32_t *gsi);
+/**
+ * Fire the event of a comparator once, ns from now.
+ *
+ * @return zero if armed, 1 if the deadline passed before the comparator
+ * could be written (the event will not fire and the caller should act as
+ * if it had), -1 on error.
+ * */
+int hpet_arm_event(uint32_t timer, uint64_t ns);
+int hpet_disarm_event(uint32_t timer);
+/**
+ * Measure the frequency of arch_get_cycles against the main counter.
+ * */
+int hpet_calibrate_cycles(ARC_HPETCalibration *out);
+int init_hpet();
+
+#endif
@@ -38,12 +38,15 @@
 
 // NOTE: Architecture specific interrupt.h header files should define a macro for creating
 //       a naked function that has the appropriate pre- and post-ambles for interrupts. The
-//       function is to be used as the function pointer argument for interrupt_set
+//       function is to be used as the function pointer argument for interrupt_set. The macro
+//       is to be named ARC_DEFINE_IRQ_HANDLER(_handler), and the function it defines is to be
+//       named ARC_NAME_IRQ(_handler)
 
 typedef enum {
         ARC_INTERRUPT_FLAGS_TRIGGER, // 1: Level, 0: Edge
         ARC_INTERRUPT_FLAGS_ACTIVE,  // 1: Low,   1: High
         ARC_INTERRUPT_FLAGS_GROUP,   // 1: Group, 0: Individual controller
+        ARC_INTERRUPT_FLAGS_MASKED,  // 1: Masked, 0: Unmasked
 } ARC_INTERRUPT_FLAGS;
 
 // The architecture specific header must define a structure specifying
@@ -53,6 +56,16 @@ typedef enum {
 
 int interrupt_set(void *handle, uint32_t number, void (*function)(), bool kernel);
 int interrupt_map_gsi(uint32_t gsi, uint32_t to_irq, uint32_t to_id, uint8_t flags);
+/**
+ * Allocate a vector no other interrupt is routed to, i.e. for a GSI routed
+ * with interrupt_map_gsi.
+ *
+ * Implemented by the architecture.
+ *
+ * @return the vector, negative if none are free.
+ * */
+int interrupt_alloc_vector();
+void interrupt_free_vector(uint32_t vector);
 int interrupt_load(void *handle);
 void interrupt_end();
 int init_static_interrupts(void *table, void *entries, int count);
@@ -0,0 +1,145 @@
+/**
+ * @file iommu.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Describe the DMA remapping units of the platform and build the translation
+ * tables of the domains devices are attached to.
+*/
+#ifndef ARC_ARCH_IOMMU_H
+#define ARC_ARCH_IOMMU_H
+
+#include "lib/spinlock.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+        ARC_IOMMU_TYPE_VTD,   // Intel VT-d, described by the DMAR
+        ARC_IOMMU_TYPE_AMDVI, // AMD-Vi, described by the IVRS
+};
+
+// Page sizes a unit can translate with
+#define ARC_IOMMU_PAGE_4K (1 << 0)
+#define ARC_IOMMU_PAGE_2M (1 << 1)
+#define ARC_IOMMU_PAGE_1G (1 << 2)
+
+// Access a mapping allows
+#define ARC_IOMMU_READ  (1 << 0)
+#define ARC_IOMMU_WRITE (1 << 1)
+
+#define ARC_IOMMU_BDF(__bus, __device, __function) (((__bus) << 8) | ((__device) << 3) | (__function))
+
+// Requester IDs from first to last, inclusive, translated by a unit
+typedef struct ARC_IOMMURange {
+        struct ARC_IOMMURange *next;
+        uint16_t first;
+        uint16_t last;
+} ARC_IOMMURange;
+
+typedef struct ARC_IOMMUUnit {
+        struct ARC_IOMMUUnit *next;
+        int type;
+        uint16_t segment;
+        // Physical address of the registers
+        uint64_t base;
+        // Requester ID of the unit itself (AMD-Vi)
+        uint16_t device_id;
+        uint32_t page_sizes;
+        // The unit translates every device of the segment not covered by
+        // another unit
+        bool include_all;
+        // The unit cannot walk the tables built here and is left disabled,
+        // the requests of its devices are not translated
+        bool disabled;
+        ARC_IOMMURange *ranges;
+        uint16_t next_domain;
+} ARC_IOMMUUnit;
+
+typedef struct ARC_IOMMUDomain {
+        ARC_IOMMUUnit *unit;
+        uint16_t id;
+        // Top level table, and its physical address for the unit
+        uint64_t *root;
+        uint64_t root_phys;
+        // Range of addresses unmapped since the last flush
+        uint64_t flush_start;
+        uint64_t flush_end;
+        // Tables detached since the last flush, freed once the unit can no
+        // longer walk them
+        void *retired;
+        ARC_Spinlock lock;
+} ARC_IOMMUDomain;
+
+ARC_IOMMUUnit *iommu_get_units();
+/**
+ * Get the unit translating the requests of a PCI function.
+ *
+ * @return the unit, NULL if the function's requests are not translated.
+ * */
+ARC_IOMMUUnit *iommu_get_unit(uint16_t segment, uint8_t bus, uint8_t device, uint8_t function);
+
+ARC_IOMMUDomain *iommu_create_domain(ARC_IOMMUUnit *unit);
+/**
+ * Free a domain and its tables, no device may be attached to it.
+ * */
+int iommu_destroy_domain(ARC_IOMMUDomain *domain);
+/**
+ * Map a range of device addresses to physical memory.
+ *
+ * The largest pages the unit supports are used wherever iova and phys are
+ * equally aligned. Mapping over an existing mapping fails.
+ *
+ * @param uint32_t flags - ARC_IOMMU_READ and / or ARC_IOMMU_WRITE.
+ * */
+int iommu_map(ARC_IOMMUDomain *domain, uint64_t iova, uint64_t phys, size_t size, uint32_t flags);
+/**
+ * Unmap a range of device addresses.
+ *
+ * Large pages straddling the edges of the range are split. The unit may keep
+ * translating the range until iommu_flush is called, which is left to the
+ * caller so that many unmaps share one invalidation.
+ * */
+int iommu_unmap(ARC_IOMMUDomain *domain, uint64_t iova, size_t size);
+/**
+ * Invalidate translations of everything unmapped since the last flush.
+ * */
+int iommu_flush(ARC_IOMMUDomain *domain);
+
+// NOTE: The following are implemented by the architecture, which programs
+//       the units themselves
+
+/**
+ * Point the context (VT-d) or device table entry (AMD-Vi) of a function at
+ * the tables of a domain.
+ * */
+int iommu_attach_device(ARC_IOMMUDomain *domain, uint8_t bus, uint8_t device, uint8_t function);
+/**
+ * Invalidate cached translations of a domain in the IOTLB of a unit.
+ * */
+int iommu_invalidate(ARC_IOMMUUnit *unit, uint16_t domain, uint64_t iova, uint64_t size);
+
+int init_iommu();
+
+#endif
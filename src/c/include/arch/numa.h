@@ -0,0 +1,63 @@
+/**
+ * @file numa.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Expose the locality of processors and memory described by the platform.
+*/
+#ifndef ARC_ARCH_NUMA_H
+#define ARC_ARCH_NUMA_H
+
+#include <stdint.h>
+
+#define ARC_NUMA_NO_NODE UINT32_MAX
+
+// Distance of a node to itself, distances to other nodes are relative to this
+#define ARC_NUMA_LOCAL_DISTANCE 10
+#define ARC_NUMA_REMOTE_DISTANCE 20
+
+// NOTE: Nodes are numbered densely from 0 in the order in which their
+//       proximity domains are first described. Without locality information
+//       there is a single node, 0, containing everything
+
+uint32_t numa_get_node_count();
+/**
+ * Get the node of a processor.
+ *
+ * @param uint32_t id - The APIC or x2APIC ID of the processor, as kept in
+ * ARC_ProcessorDescriptor.acpi_uid.
+ * */
+uint32_t numa_get_processor_node(uint32_t id);
+uint32_t numa_get_address_node(uint64_t address);
+uint32_t numa_get_node_domain(uint32_t node);
+uint32_t numa_get_domain_node(uint32_t domain);
+/**
+ * Get the relative distance between two nodes.
+ *
+ * @return ARC_NUMA_LOCAL_DISTANCE if from and to are the same node, a
+ * greater value otherwise. UINT8_MAX if either node is invalid.
+ * */
+uint8_t numa_get_distance(uint32_t from, uint32_t to);
+int init_numa();
+
+#endif
@@ -28,10 +28,12 @@
 #ifndef ARC_ARCH_PAGER_H
 #define ARC_ARCH_PAGER_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
-// TODO: Make this abstract. In its current state, it is specific to x86-64
+// TODO: Make the attributes abstract. In their current state, they are
+//       specific to x86-64
 
 enum {
         // Page attributes
@@ -56,6 +58,35 @@ enum {
         ARC_PAGER_AUTO_USRW_DISABLE,
         // Reserved for internal use
         ARC_PAGER_RESV3 = 15,
+        // 1: Coalesce the surrounding 2M or 1G region into a large page
+        //    once it is fully and contiguously mapped with equal attributes
+        ARC_PAGER_PROMOTE,
+        // 1: Only reserve the range in pager_fly_map, pages are mapped by
+        //    pager_resolve_fault once touched
+        ARC_PAGER_RESERVE,
+};
+
+// How a reserved range is expected to be touched, see pager_advise
+enum {
+        // Map the aligned cluster of pages around a fault
+        ARC_PAGER_HINT_NORMAL,
+        // Map the cluster of pages following a fault
+        ARC_PAGER_HINT_SEQUENTIAL,
+        // Map only the faulting page
+        ARC_PAGER_HINT_RANDOM,
+        // Map the first count pages right away, then as normal
+        ARC_PAGER_HINT_POPULATE,
+};
+
+// Pages mapped per fault of a reserved range, unless ARC_PAGER_HINT_RANDOM
+#define ARC_PAGER_FAULT_CLUSTER 16
+
+// Bits of the flags of pager_clone, set as with the attributes (i.e.
+// 1 << ARC_PAGER_CLONE_COW)
+enum {
+        // 1: Share the frames instead of mapping them anew, both sides are
+        //    made read-only and marked copy-on-write
+        ARC_PAGER_CLONE_COW,
 };
 
 // Indices in the 0x277 MSR (page attributes)
@@ -68,16 +99,364 @@ enum {
         ARC_PAGER_WP,       // WP
 };
 
+// Invalidation a batch settles on when it is committed
+enum {
+        ARC_PAGER_FLUSH_NONE,
+        // INVLPG each page between the lowest and highest changed address
+        ARC_PAGER_FLUSH_PAGES,
+        // Invalidate everything between the lowest and highest changed
+        // address, as cheaply as the architecture can
+        ARC_PAGER_FLUSH_RANGE,
+        // Reload the page tables
+        ARC_PAGER_FLUSH_ALL,
+};
+
+// Largest span of changed pages a batch invalidates page by page, and as a
+// range
+#define ARC_PAGER_BATCH_MAX_PAGES 32
+#define ARC_PAGER_BATCH_MAX_RANGE 0x200000
+
+typedef struct ARC_PagerBatch {
+        void *page_tables;
+        // 4K pages changed
+        size_t page_count;
+        // Lowest and highest changed address, exclusive
+        uintptr_t flush_start;
+        uintptr_t flush_end;
+        // Frames unmapped by the change, and page tables it emptied, that may
+        // only be reused once the TLB no longer references them
+        void *freed_frames;
+        size_t freed_frame_count;
+        void *freed_tables;
+        size_t freed_table_count;
+} ARC_PagerBatch;
+
+// Pages of each size present in a set of page tables
+typedef struct ARC_PagerStats {
+        size_t pages_4k;
+        size_t pages_2m;
+        size_t pages_1g;
+        // Large pages split by partial unmaps or attribute changes
+        size_t demotions;
+        // Regions coalesced into a large page
+        size_t promotions;
+} ARC_PagerStats;
+
+typedef struct ARC_PagerTranslation {
+        // Physical address the translated address maps to
+        uintptr_t physical;
+        // Size of the page holding the mapping
+        size_t page_size;
+        // ARC_PAGER_* attributes of the mapping
+        uint32_t attributes;
+} ARC_PagerTranslation;
+
+typedef struct ARC_PagerReservationStats {
+        uintptr_t virtual;
+        size_t size;
+        int hint;
+        // Faults resolved, and pages mapped by them
+        size_t faults;
+        size_t pages;
+} ARC_PagerReservationStats;
+
+// Physically contiguous part of a virtual range
+typedef struct ARC_PagerExtent {
+        uintptr_t virtual;
+        uintptr_t physical;
+        size_t size;
+} ARC_PagerExtent;
+
+// Operations the architecture implements on its page tables, behind the
+// pager_* functions.
+//
+// Changes are recorded into the batch passed along, with
+// pager_batch_add for changed ranges, and pager_batch_free_frame and
+// pager_batch_free_table for pages that may only be reused after
+// invalidation, which is left to the frontend
+typedef struct ARC_PagerBackend {
+        // Levels of the page tables (i.e. 4 or 5 on x86-64)
+        int levels;
+        void *(*create)();
+        int (*destroy)(ARC_PagerBatch *batch);
+        int (*map)(ARC_PagerBatch *batch, uintptr_t virtual, uintptr_t physical, size_t size, uint32_t attributes);
+        int (*unmap)(ARC_PagerBatch *batch, uintptr_t virtual, size_t size, void **physical);
+        int (*fly_map)(ARC_PagerBatch *batch, uintptr_t virtual, size_t size, uint32_t attributes);
+        int (*fly_unmap)(ARC_PagerBatch *batch, uintptr_t virtual, size_t size);
+        int (*set_attr)(ARC_PagerBatch *batch, uintptr_t virtual, size_t size, uint32_t attributes);
+        int (*promote)(ARC_PagerBatch *batch, uintptr_t virtual, size_t size);
+        int (*clone)(ARC_PagerBatch *dest, ARC_PagerBatch *src, uintptr_t virt_src, uintptr_t virt_dest, size_t size, uint32_t flags);
+        int (*resolve_cow)(ARC_PagerBatch *batch, uintptr_t virtual);
+        int (*translate)(void *page_tables, uintptr_t virtual, ARC_PagerTranslation *translation);
+        int (*get_stats)(void *page_tables, ARC_PagerStats *stats);
+        void (*flush_local)(int kind, uintptr_t start, uintptr_t end);
+        void (*load_local)(void *page_tables, uint32_t tag, bool flush);
+} ARC_PagerBackend;
+
+// Top level entries of a set of page tables, and the first of those
+// covering the kernel half
+#define ARC_PAGER_ROOT_ENTRIES 512
+#define ARC_PAGER_KERNEL_ROOT_FIRST 256
+
 extern uintptr_t Arc_KernelPageTables;
 
+/**
+ * Create a set of page tables sharing the kernel half.
+ *
+ * init_pager allocates a table behind every kernel half top level entry of
+ * Arc_KernelPageTables, so those entries never change afterwards. New page
+ * tables take one page from pager_alloc_table and copy the entries, so any
+ * later kernel mapping (HHDM growth, processor structures, etc.) is seen by
+ * every address space without being propagated.
+ * */
 void *pager_create_page_tables();
+/**
+ * Free a set of page tables.
+ *
+ * Only the user half is freed, the kernel half belongs to
+ * Arc_KernelPageTables.
+ *
+ * No thread may run on the tables anymore, but a processor running a kernel
+ * thread lazily may still have them loaded. Before anything is freed,
+ * smp_tlb_release switches every such processor, lazy and idle ones
+ * included, to Arc_KernelPageTables and drops the tags of the tables.
+ * */
 int pager_delete_page_tables(void *page_tables);
+/**
+ * Map a range of virtual memory to physical memory.
+ *
+ * Unless ARC_PAGER_4K is set, 1G and 2M pages are used wherever virtual and
+ * physical are equally aligned and the rest of the range covers the page.
+ * */
 int pager_map(void *page_tables, uintptr_t virtual, uintptr_t physical, size_t size, uint32_t attributes) ;
+/**
+ * Unmap a range of virtual memory.
+ *
+ * A large page only partly covered by the range is split into the next
+ * smaller size, down to 4K, so that exactly the range is unmapped.
+ * */
 int pager_unmap(void *page_tables, uintptr_t virtual, size_t size, void **physical);
+/**
+ * Map a range of virtual memory to newly allocated memory.
+ *
+ * With ARC_PAGER_RESERVE, the range and attributes are only recorded and
+ * memory is allocated by pager_resolve_fault.
+ * */
 int pager_fly_map(void *page_tables, uintptr_t virtual, size_t size, uint32_t attributes);
+/**
+ * Unmap and free a range mapped by pager_fly_map, releasing any reservation
+ * of it.
+ *
+ * Pages of a reservation that were never touched are not mapped, the backend
+ * skips them.
+ * */
 int pager_fly_unmap(void *page_tables, uintptr_t virtual, size_t size);
+/**
+ * Set how a reserved range is expected to be touched.
+ *
+ * @param int hint - One of ARC_PAGER_HINT_*.
+ * @param size_t count - Pages to map now for ARC_PAGER_HINT_POPULATE.
+ * */
+int pager_advise(void *page_tables, uintptr_t virtual, int hint, size_t count);
+/**
+ * Map the pages of a reservation around a faulting address, as its hint
+ * suggests.
+ *
+ * @return 0 if the fault was resolved, 1 if the address is not reserved,
+ * -1 on failure.
+ * */
+int pager_resolve_fault(void *page_tables, uintptr_t virtual);
+int pager_get_reservation_stats(void *page_tables, uintptr_t virtual, ARC_PagerReservationStats *stats);
+/**
+ * Change the attributes of a mapped range.
+ *
+ * Only runs of pages whose attributes differ are rewritten, unmapped pages
+ * are skipped. Large pages straddling the edges of the range are split as in
+ * pager_unmap, and merged back afterwards where the change left the 2M
+ * region around an edge uniform. Edges mapped with 4K pages beforehand are
+ * left so. All of it is invalidated at once.
+ * */
 int pager_set_attr(void *page_tables, uintptr_t virtual, size_t size, uint32_t attributes);
-int pager_clone(void *dest, void *src, uintptr_t virt_src, uintptr_t virt_dest, size_t size);
+/**
+ * Coalesce every 2M and 1G region within a range that is fully and
+ * contiguously mapped with equal attributes into a large page.
+ *
+ * @return the number of large pages created, negative on failure.
+ * */
+int pager_promote(void *page_tables, uintptr_t virtual, size_t size);
+/**
+ * Translate a virtual address with a single walk of the page tables.
+ *
+ * If the address is not mapped, only page_size is written, with the size of
+ * the aligned unmapped region around the address the walk stopped at (i.e.
+ * 2M if the page directory entry is empty), or 4K if the backend cannot tell.
+ *
+ * @return 0 if the address is mapped, -1 otherwise.
+ * */
+int pager_translate(void *page_tables, uintptr_t virtual, ARC_PagerTranslation *translation);
+/**
+ * Translate a virtual range into physically contiguous extents, i.e. for a
+ * scatter-gather list.
+ *
+ * Each page is walked once, whatever its size. Translation stops at the
+ * first unmapped page or once max extents are filled, the extents then cover
+ * less than size.
+ *
+ * @return the number of extents filled.
+ * */
+int pager_translate_range(void *page_tables, uintptr_t virtual, size_t size, ARC_PagerExtent *extents, int max);
+int pager_get_stats(void *page_tables, ARC_PagerStats *stats);
+/**
+ * Duplicate the mappings of a range of src at a range of dest.
+ *
+ * With 1 << ARC_PAGER_CLONE_COW, each shared frame is counted with
+ * pager_share_frame and the entries on both sides are marked read-only and
+ * copy-on-write with a software bit, until pager_resolve_cow gives a writer
+ * its own frame.
+ *
+ * @param uint32_t flags - ARC_PAGER_CLONE_* bits, 0 to map the frames anew.
+ * */
+int pager_clone(void *dest, void *src, uintptr_t virt_src, uintptr_t virt_dest, size_t size, uint32_t flags);
+/**
+ * Resolve a write fault on a copy-on-write page.
+ *
+ * If the faulting mapping is the last one sharing the frame, it is made
+ * writable again. Otherwise the frame is copied to a new, writable frame and
+ * the mapping's share is dropped with pager_unshare_frame.
+ *
+ * @return 0 if the fault was resolved, 1 if the page is not copy-on-write,
+ * -1 on failure.
+ * */
+int pager_resolve_cow(void *page_tables, uintptr_t virtual);
+/**
+ * Count a new mapping of a frame.
+ *
+ * The first share of a frame counts both its owner and the new mapping.
+ * */
+int pager_share_frame(uintptr_t physical);
+/**
+ * Drop a mapping of a frame.
+ *
+ * @return the number of mappings left, 0 if the frame was not shared and
+ * may be freed by the caller.
+ * */
+int pager_unshare_frame(uintptr_t physical);
+uint32_t pager_get_frame_shares(uintptr_t physical);
+/**
+ * Start queuing changes to a set of page tables.
+ *
+ * The pager_batch_* functions edit the tables like their pager_*
+ * counterparts but do not invalidate the TLB, so the new mappings are only
+ * guaranteed to be seen after pager_batch_commit. A batch belongs to one
+ * thread and must be committed before the tables are switched away from.
+ * The pager_* functions are each a batch of one change.
+ * */
+int pager_batch_begin(ARC_PagerBatch *batch, void *page_tables);
+/**
+ * Record a changed range, to be called by the backend.
+ * */
+void pager_batch_add(ARC_PagerBatch *batch, uintptr_t virtual, size_t size);
+/**
+ * Queue a frame of data to be freed once the batch is invalidated, to be
+ * called by the backend.
+ *
+ * @param void *frame - The frame in the HHDM, its first word is overwritten.
+ * */
+void pager_batch_free_frame(ARC_PagerBatch *batch, void *frame);
+/**
+ * Queue an emptied page table to be returned to the page table pool once the
+ * batch is invalidated, to be called by the backend.
+ *
+ * @param void *table - The table in the HHDM, its first word is overwritten.
+ * */
+void pager_batch_free_table(ARC_PagerBatch *batch, void *table);
+int pager_batch_map(ARC_PagerBatch *batch, uintptr_t virtual, uintptr_t physical, size_t size, uint32_t attributes);
+int pager_batch_unmap(ARC_PagerBatch *batch, uintptr_t virtual, size_t size);
+int pager_batch_set_attr(ARC_PagerBatch *batch, uintptr_t virtual, size_t size, uint32_t attributes);
+/**
+ * Invalidate everything the batch changed with one flush.
+ *
+ * The flush is ARC_PAGER_FLUSH_PAGES if the changed span is at most
+ * ARC_PAGER_BATCH_MAX_PAGES pages, ARC_PAGER_FLUSH_RANGE if it is at most
+ * ARC_PAGER_BATCH_MAX_RANGE, and ARC_PAGER_FLUSH_ALL otherwise. Other
+ * processors are reached through a single smp_tlb_shootdown. If the batch
+ * freed page tables, that shootdown also interrupts the lazy and idle
+ * processors that have the tables loaded rather than deferring them, as
+ * their walks may still reach the tables. Freed page tables are then
+ * returned to the invoking processor's pool.
+ *
+ * @param void **freed - Set to a list of the freed frames, each linking to
+ * the next through its first word in the HHDM. If NULL, the frames are
+ * returned to the allocator.
+ * @return the number of freed frames and tables, negative on failure.
+ * */
+int pager_batch_commit(ARC_PagerBatch *batch, void **freed);
+/**
+ * Invalidate translations on the invoking processor only, through the
+ * backend.
+ *
+ * Only translations under the loaded tag are invalidated, except for global
+ * pages, which ARC_PAGER_FLUSH_ALL includes along with every tag.
+ *
+ * @param int kind - One of ARC_PAGER_FLUSH_*, with ARC_PAGER_FLUSH_PAGES
+ * invalidating each page between start and end.
+ * */
+void pager_flush_local(int kind, uintptr_t start, uintptr_t end);
+/**
+ * Load a set of page tables on the invoking processor, through the backend.
+ *
+ * @param uint32_t tag - Tag returned by smp_tlb_switch for the tables.
+ * @param bool flush - Flush the translations cached under the tag, as
+ * returned by smp_tlb_switch.
+ * */
+void pager_load_local(void *page_tables, uint32_t tag, bool flush);
+/**
+ * Get a zeroed page for a page table.
+ *
+ * Taken from the invoking processor's pool, which is refilled from the
+ * allocator in bulk when empty. Used by pager_create_page_tables and for the
+ * intermediate tables of pager_map.
+ * */
+void *pager_alloc_table();
+int pager_free_table(void *table);
+/**
+ * Return a list of page tables to the invoking processor's pool, as
+ * pager_batch_commit does.
+ *
+ * @param void *tables - Tables linked through their first word, as queued
+ * by pager_batch_free_table.
+ * @return the number of tables returned.
+ * */
+int pager_free_tables(void *tables);
+/**
+ * Zero up to max freed tables of the invoking processor's pool, so that later
+ * allocations need not.
+ *
+ * @return the number of tables zeroed.
+ * */
+int pager_zero_tables(uint32_t max);
+/**
+ * Allocate the pools of up to max processors, each of which registers itself
+ * on its first use of the pool. Processors beyond max, and uses before this,
+ * go to the allocator directly.
+ *
+ * Called by init_pager.
+ * */
+int init_pager_pool(uint32_t max);
+/**
+ * Install the backend the pager_* functions operate through, done by
+ * init_pager.
+ * */
+int pager_set_backend(ARC_PagerBackend *backend);
+/**
+ * Set up Arc_KernelPageTables, including the tables behind every kernel half
+ * top level entry, and install the architecture's backend.
+ *
+ * Calls init_pager_pool with the number of processors the platform
+ * describes, first so that the tables it allocates come from the pool.
+ *
+ * Implemented by the architecture.
+ * */
 int init_pager();
 
 #endif
@@ -162,6 +162,9 @@ typedef struct ARC_PCIHeaderMeta {
 	uint8_t device;
 	uint8_t function;
 	bool is_mmio;
+	// NUMA node of the host bridge the function is behind,
+	// ARC_NUMA_NO_NODE if unknown
+	uint32_t numa_node;
 	ARC_PCIHeader *header;
 } ARC_PCIHeaderMeta;
 
@@ -0,0 +1,134 @@
+/**
+ * @file power.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Expose the idle and performance states of processors described by the
+ * platform, and choose idle states for processors about to hold.
+*/
+#ifndef ARC_ARCH_POWER_H
+#define ARC_ARCH_POWER_H
+
+#include "arch/acpi/table.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ARC_POWER_MAX_CSTATES 8
+// No limit on the exit latency of idle states
+#define ARC_POWER_NO_LATENCY_LIMIT UINT64_MAX
+
+// How an idle state is entered
+enum {
+        ARC_CSTATE_ENTRY_HALT, // Halt until the next interrupt (C1)
+        ARC_CSTATE_ENTRY_IO,   // Read from the I/O port at address
+        ARC_CSTATE_ENTRY_FFH,  // Architecture specific, address is a hint
+                               // (i.e. for MWAIT on x86-64)
+};
+
+typedef struct ARC_CState {
+        // ACPI C state type, 1 to 3
+        uint8_t type;
+        uint8_t entry;
+        uint64_t address;
+        // Vendor specific flags for ARC_CSTATE_ENTRY_FFH
+        uint32_t flags;
+        uint32_t latency_ns;
+        // Least idle duration for which entering the state saves power
+        uint32_t residency_ns;
+        uint32_t power_mw;
+} ARC_CState;
+
+typedef struct ARC_PState {
+        uint32_t frequency_mhz;
+        uint32_t power_mw;
+        uint32_t latency_us;
+        uint32_t bus_master_latency_us;
+        // Written to the _PCT control register to switch to the state
+        uint64_t control;
+        // Read from the _PCT status register once in the state
+        uint64_t status;
+} ARC_PState;
+
+// Collaborative processor performance control (_CPC), in abstract units
+typedef struct ARC_PowerCPC {
+        bool present;
+        uint32_t highest;
+        uint32_t nominal;
+        uint32_t lowest_nonlinear;
+        uint32_t lowest;
+        ARC_ACPIGas desired;
+} ARC_PowerCPC;
+
+typedef struct ARC_ProcessorPower {
+        uint32_t acpi_uid;
+        // Ordered from shallowest to deepest
+        ARC_CState cstates[ARC_POWER_MAX_CSTATES];
+        uint32_t cstate_count;
+        ARC_PState *pstates;
+        uint32_t pstate_count;
+        ARC_ACPIGas pstate_control;
+        ARC_ACPIGas pstate_status;
+        ARC_PowerCPC cpc;
+        // Exit latency the processor tolerates, ARC_POWER_NO_LATENCY_LIMIT
+        // by default
+        uint64_t latency_limit_ns;
+        // Running average of the idle durations of the processor
+        uint64_t predicted_ns;
+} ARC_ProcessorPower;
+
+ARC_ProcessorPower *power_get_processor(uint32_t acpi_uid);
+/**
+ * Cap the exit latency of the idle states chosen for a processor.
+ *
+ * @param uint64_t limit_ns - Largest tolerable latency, 0 restricts the
+ * processor to halting, ARC_POWER_NO_LATENCY_LIMIT lifts the cap.
+ * */
+int power_set_latency_limit(uint32_t acpi_uid, uint64_t limit_ns);
+/**
+ * Choose the idle state to hold a processor in.
+ *
+ * The deepest state whose exit latency is within the processor's limit and
+ * whose target residency is within the predicted idle duration is chosen.
+ * The prediction is the lesser of until_ns and the average of previous
+ * idle durations.
+ *
+ * @param ARC_ProcessorPower *power - The processor.
+ * @param uint64_t until_ns - Time until the next known event (i.e. timer),
+ * UINT64_MAX if there is none.
+ * @return the chosen state, never NULL if power is not NULL.
+ * */
+ARC_CState *power_select_cstate(ARC_ProcessorPower *power, uint64_t until_ns);
+/**
+ * Account for the time a processor spent idle, to improve later predictions.
+ * */
+void power_idle_exit(ARC_ProcessorPower *power, uint64_t idle_ns);
+/**
+ * Enter an idle state, returning once the processor is woken.
+ *
+ * Implemented by the architecture, as used by smp_hold.
+ * */
+int power_enter_cstate(ARC_CState *state);
+int init_power();
+
+#endif
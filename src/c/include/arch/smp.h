@@ -33,6 +33,7 @@
 #include "userspace/process.h"
 #include "userspace/thread.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
 // Offsets into flags attribute
@@ -64,16 +65,191 @@ typedef struct ARC_ProcessorDescriptor {
 	uint32_t timer_mode;
 } ARC_ProcessorDescriptor;
 
+// Placement of a processor in the platform's topology. The IDs are opaque,
+// processors sharing a core, last level cache or package have the same
+// respective ID
+typedef struct ARC_ProcessorTopology {
+        uint32_t acpi_uid;
+        uint32_t apic_id;
+        uint32_t core;
+        uint32_t llc;
+        uint32_t package;
+        uint32_t node;
+} ARC_ProcessorTopology;
+
+// What a processor does with the page tables it has loaded
+enum {
+        // Running on the tables, every shootdown must reach it
+        ARC_SMP_TLB_ACTIVE,
+        // Running a kernel thread on borrowed tables, shootdowns of the tables
+        // are deferred until it resumes
+        ARC_SMP_TLB_LAZY,
+        // Idling, all shootdowns are deferred until it resumes
+        ARC_SMP_TLB_IDLE,
+};
+
+// Address space tags (PCIDs on x86-64) each processor hands out, tag 0 is
+// left for use before the processor is tracked
+#define ARC_SMP_TLB_TAGS 6
+
+#define ARC_SMP_PARK_FOREVER UINT64_MAX
+
 extern uint32_t Arc_ProcessorCounter;
 
 /**
  * Hold the invoking processor.
+ *
+ * The processor idles in the state power_select_cstate chooses for it, after
+ * zeroing freed page tables with pager_zero_tables.
  * */
 void smp_hold();
 ARC_ProcessorDescriptor *smp_get_proc_desc();
 uint32_t smp_get_processor_id();
 void smp_switch_to(ARC_Context *ctx);
+/**
+ * Block the current thread while a word holds an expected value.
+ *
+ * The check and the block are atomic with respect to smp_unpark, so a change
+ * of the word followed by smp_unpark is never missed. Returns early on
+ * spurious wake ups, callers re-check their condition.
+ *
+ * Implemented by the architecture, which switches threads.
+ *
+ * @param uint64_t timeout_ns - Longest time to block for, ARC_SMP_PARK_FOREVER
+ * to block until woken.
+ * @return 0 if woken or the word did not hold expected, 1 on timeout.
+ * */
+int smp_park(uint64_t *word, uint64_t expected, uint64_t timeout_ns);
+/**
+ * Wake up to count threads parked on a word.
+ * */
+int smp_unpark(uint64_t *word, uint32_t count);
+/**
+ * Map the structures of every processor into a set of page tables.
+ *
+ * Mappings in the kernel half of Arc_KernelPageTables are shared by every
+ * set of page tables, so this is only needed for the user half.
+ * */
 int smp_map_processor_structures(void *page_tables);
+/**
+ * Bring up the application processors.
+ *
+ * Implemented by the architecture, which calls init_smp_tlb with the number
+ * of processors the platform describes before starting any of them. Each
+ * processor then loads its first page tables through smp_tlb_switch.
+ * */
 int init_smp();
 
+/**
+ * Get the number of low APIC ID bits that tell processors apart within a
+ * core, a last level cache and a package.
+ *
+ * Implemented by the architecture (i.e. from CPUID leaves 0x1F, 0xB and 0x4
+ * on x86-64), used to derive the topology when the platform does not
+ * describe every processor in a PPTT.
+ * */
+int smp_get_apic_id_shifts(uint32_t *smt_shift, uint32_t *llc_shift, uint32_t *package_shift);
+
+uint32_t smp_get_topology_count();
+ARC_ProcessorTopology *smp_get_topology(uint32_t index);
+ARC_ProcessorTopology *smp_get_topology_by_uid(uint32_t acpi_uid);
+/**
+ * Get the processors sharing a last level cache with a processor.
+ *
+ * @param uint32_t acpi_uid - The processor.
+ * @param uint32_t *out - Set to the ACPI UIDs of the other processors, may be
+ * NULL.
+ * @param uint32_t max - Number of entries out can hold.
+ * @return the number of other processors sharing the cache, -1 if the
+ * processor is unknown.
+ * */
+int smp_get_llc_siblings(uint32_t acpi_uid, uint32_t *out, uint32_t max);
+/**
+ * Get the processors sharing a core with a processor.
+ *
+ * See smp_get_llc_siblings.
+ * */
+int smp_get_smt_siblings(uint32_t acpi_uid, uint32_t *out, uint32_t max);
+int init_smp_topology();
+
+/**
+ * Record the page tables the invoking processor is about to load, and get
+ * the tag to load them with.
+ *
+ * Each processor tags the ARC_SMP_TLB_TAGS page tables it switched to most
+ * recently. Translations under a tag stay valid while the processor runs
+ * other tables, as shootdowns skipping it drop the tag instead.
+ *
+ * Must be called before the tables are loaded, so that no shootdown of them
+ * can be missed. The first call on a processor registers it with the
+ * shootdowns, which reach it from then on.
+ *
+ * @param bool *flush - Set to true if the translations cached under the tag
+ * are stale and must be flushed by the load (i.e. CR3 without bit 63).
+ * @return the tag, from 1 to ARC_SMP_TLB_TAGS, or 0 if the processor cannot
+ * be tracked (i.e. before init_smp_tlb).
+ * */
+uint32_t smp_tlb_switch(void *page_tables, bool *flush);
+/**
+ * Drop the tags of page tables on every processor, to be called once they
+ * are deleted so that tables later allocated at the same address are not
+ * mistaken for them.
+ * */
+void smp_tlb_forget(void *page_tables);
+/**
+ * Move every processor off page tables about to be deleted.
+ *
+ * Processors with the tables loaded, lazy and idle ones included, are
+ * interrupted and switch to Arc_KernelPageTables through pager_load_local,
+ * as does the invoking processor. The tags of the tables are then dropped as
+ * with smp_tlb_forget.
+ * */
+int smp_tlb_release(void *page_tables);
+/**
+ * Enter ARC_SMP_TLB_LAZY or ARC_SMP_TLB_IDLE on the invoking processor.
+ * */
+void smp_tlb_enter(int state);
+/**
+ * Return the invoking processor to ARC_SMP_TLB_ACTIVE.
+ *
+ * If a shootdown was deferred in the meantime, the TLB is flushed entirely.
+ * */
+void smp_tlb_resume();
+/**
+ * Invalidate translations of a set of page tables on every processor that
+ * may cache them.
+ *
+ * Processors with other tables loaded are left alone, unless page_tables are
+ * Arc_KernelPageTables whose mappings every processor shares. Processors
+ * that are lazy or idle are not interrupted but flush once they resume,
+ * unless freed_tables is set. All others, including the invoking processor,
+ * are sent one request and have acknowledged it by the time this returns.
+ *
+ * @param int kind - ARC_PAGER_FLUSH_RANGE or ARC_PAGER_FLUSH_ALL.
+ * @param uintptr_t start - First address to invalidate.
+ * @param uintptr_t end - Address after the last to invalidate.
+ * @param bool freed_tables - Tables were unlinked from page_tables and are
+ * about to be reused. A lazy or idle processor still has page_tables loaded
+ * and may walk them, so every processor with them loaded is interrupted.
+ * */
+int smp_tlb_shootdown(void *page_tables, int kind, uintptr_t start, uintptr_t end, bool freed_tables);
+/**
+ * Carry out the shootdown request sent to the invoking processor, to be
+ * called by the handler of the IPI smp_send_tlb_ipi sends.
+ * */
+void smp_tlb_handle_shootdown();
+/**
+ * Send the shootdown IPI to a processor.
+ *
+ * Implemented by the architecture.
+ * */
+int smp_send_tlb_ipi(uint32_t apic_id);
+/**
+ * Allocate the tracking of up to max processors, which register themselves
+ * with their first smp_tlb_switch.
+ *
+ * Called by init_smp.
+ * */
+int init_smp_tlb(uint32_t max);
+
 #endif
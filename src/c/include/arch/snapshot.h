@@ -0,0 +1,165 @@
+/**
+ * @file snapshot.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Save the decoded platform state into a flat blob that a later boot can
+ * consume instead of rescanning ACPI and PCI.
+*/
+#ifndef ARC_ARCH_SNAPSHOT_H
+#define ARC_ARCH_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// "ARCSNAP", NUL terminated
+#define ARC_SNAPSHOT_MAGIC 0x0050414E53435241
+#define ARC_SNAPSHOT_VERSION 1
+
+// Sections of the blob, each is an array of fixed size records
+enum {
+        ARC_SNAPSHOT_TOPOLOGY,      // ARC_ProcessorTopology
+        ARC_SNAPSHOT_MCFG,          // ARC_MCFGEntry
+        ARC_SNAPSHOT_PCI_ROOT,      // ARC_SnapshotPCIRoot
+        ARC_SNAPSHOT_PCI_FUNCTION,  // ARC_SnapshotPCIFunction
+        ARC_SNAPSHOT_ACPI_DEVICE,   // ARC_SnapshotACPIDevice
+        ARC_SNAPSHOT_ACPI_IO,       // ARC_SnapshotACPIIO
+        ARC_SNAPSHOT_ACPI_IRQ,      // ARC_SnapshotACPIIRQ
+        ARC_SNAPSHOT_SECTION_MAX,
+};
+
+typedef struct ARC_SnapshotSection {
+        // From the start of the blob
+        uint32_t offset;
+        uint32_t count;
+        uint32_t record_size;
+        uint32_t resv0;
+} ARC_SnapshotSection;
+
+typedef struct ARC_SnapshotHeader {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t size;
+        // Hash of the headers of all ACPI tables, see snapshot_fingerprint
+        uint64_t fingerprint;
+        // hash_fnv1a of the blob following the header
+        uint64_t checksum;
+        ARC_SnapshotSection sections[ARC_SNAPSHOT_SECTION_MAX];
+} ARC_SnapshotHeader;
+
+typedef struct ARC_SnapshotPCIRoot {
+        uint16_t segment;
+        uint8_t bus;
+        uint8_t resv0;
+        uint32_t node;
+} ARC_SnapshotPCIRoot;
+
+typedef struct ARC_SnapshotPCIFunction {
+        uint16_t segment;
+        uint8_t bus;
+        uint8_t device;
+        uint8_t function;
+        uint8_t resv0;
+        // Checked against the function found at the same address
+        uint16_t vendor_id;
+        uint16_t device_id;
+        uint16_t resv1;
+        uint32_t node;
+} ARC_SnapshotPCIFunction;
+
+// Followed by io_count records in ARC_SNAPSHOT_ACPI_IO and irq_count records
+// in ARC_SNAPSHOT_ACPI_IRQ, in the order of the devices
+typedef struct ARC_SnapshotACPIDevice {
+        uint64_t hash;
+        uint32_t node;
+        uint16_t io_count;
+        uint16_t irq_count;
+} ARC_SnapshotACPIDevice;
+
+typedef struct ARC_SnapshotACPIIO {
+        uint32_t base;
+        uint32_t length;
+        uint32_t align;
+        uint32_t decode_type;
+} ARC_SnapshotACPIIO;
+
+// IRQ descriptors select at most 16 IRQs
+#define ARC_SNAPSHOT_MAX_IRQS 16
+
+typedef struct ARC_SnapshotACPIIRQ {
+        uint8_t irqs[ARC_SNAPSHOT_MAX_IRQS];
+        uint8_t irq_count;
+        uint8_t polarity;
+        uint8_t sharing;
+        uint8_t triggering;
+        uint8_t wake_capability;
+        uint8_t length_kind;
+        uint8_t resv0[2];
+} ARC_SnapshotACPIIRQ;
+
+/**
+ * Hash the headers of every table the RSDP leads to.
+ *
+ * Each header carries the length, checksum and revision of its table, so a
+ * change in firmware or hardware configuration changes the fingerprint.
+ * */
+uint64_t snapshot_fingerprint();
+/**
+ * Consume a snapshot instead of scanning the platform.
+ *
+ * Called before init_acpi with a blob produced by snapshot_save on a
+ * previous boot (i.e. passed through kexec or boot metadata). The blob is
+ * used in place and must stay mapped. Blobs that are corrupt, of another
+ * version or of other tables are rejected.
+ *
+ * @return zero if the blob will be used.
+ * */
+int snapshot_load(void *blob, size_t size);
+/**
+ * Serialize the state decoded during this boot.
+ *
+ * @param void **out - Set to the blob, allocated with alloc.
+ * @return the size of the blob, 0 on failure.
+ * */
+size_t snapshot_save(void **out);
+/**
+ * Get a section of the loaded snapshot.
+ *
+ * @return the records of the section, NULL if no snapshot was loaded.
+ * */
+void *snapshot_get(int section, uint32_t *count);
+/**
+ * Remember a record for the next snapshot_save, ignored if a snapshot was
+ * loaded and the section was not discarded.
+ * */
+int snapshot_record(int section, const void *record);
+/**
+ * Drop a section of the loaded snapshot that no longer matches the platform.
+ *
+ * Called when replaying a section failed, before falling back to scanning.
+ * The section is hidden from snapshot_get and the scan records it afresh,
+ * so that snapshot_save writes what was found rather than the stale copy.
+ * */
+void snapshot_discard(int section);
+
+#endif
@@ -0,0 +1,719 @@
+/**
+ * @file iommu.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Discover DMA remapping units from the DMAR or IVRS, and build the
+ * translation tables of their domains.
+*/
+#include "arch/acpi/table.h"
+#include "arch/iommu.h"
+#include "arch/pager.h"
+#include "arch/pci.h"
+#include "global.h"
+#include "mm/allocator.h"
+
+#define IOMMU_TABLE_SIZE 0x1000
+#define IOMMU_TABLE_ENTRIES 512
+#define IOMMU_LEVELS 4
+#define IOMMU_LEVEL_SHIFT(__level) (12 + 9 * ((__level) - 1))
+#define IOMMU_LEVEL_SIZE(__level) (1ULL << IOMMU_LEVEL_SHIFT(__level))
+#define IOMMU_LEVEL_INDEX(__address, __level) (((__address) >> IOMMU_LEVEL_SHIFT(__level)) & (IOMMU_TABLE_ENTRIES - 1))
+#define IOMMU_ADDRESS_MASK 0x000FFFFFFFFFF000
+
+// Second level table entries of VT-d
+#define IOMMU_VTD_READ  (1 << 0)
+#define IOMMU_VTD_WRITE (1 << 1)
+#define IOMMU_VTD_LARGE (1 << 7)
+
+// Table entries of AMD-Vi, a next level of 0 marks a page
+#define IOMMU_AMD_PRESENT (1 << 0)
+#define IOMMU_AMD_NEXT_LEVEL(__level) ((uint64_t)(__level) << 9)
+#define IOMMU_AMD_NEXT_LEVEL_MASK (7 << 9)
+#define IOMMU_AMD_READ  (1ULL << 61)
+#define IOMMU_AMD_WRITE (1ULL << 62)
+
+// VT-d capability registers
+#define IOMMU_VTD_REG_CAP  0x08
+#define IOMMU_VTD_REG_ECAP 0x10
+#define IOMMU_VTD_CAP_SAGAW(__cap) (((__cap) >> 8) & 0x1F)
+#define IOMMU_VTD_CAP_SLLPS(__cap) (((__cap) >> 34) & 0xF)
+#define IOMMU_VTD_SAGAW_4_LEVEL (1 << 2)
+#define IOMMU_VTD_ECAP_COHERENT (1 << 0)
+
+// Secondary and subordinate bus numbers of a bridge
+#define IOMMU_PCI_BRIDGE_BUSES 0x18
+
+struct iommu_retired {
+	struct iommu_retired *next;
+	uint64_t *table;
+	int level;
+};
+
+static ARC_IOMMUUnit *iommu_units = NULL;
+static ARC_IOMMUUnit *iommu_units_tail = NULL;
+
+ARC_IOMMUUnit *iommu_get_units() {
+	return iommu_units;
+}
+
+ARC_IOMMUUnit *iommu_get_unit(uint16_t segment, uint8_t bus, uint8_t device, uint8_t function) {
+	uint16_t bdf = ARC_IOMMU_BDF(bus, device, function);
+	ARC_IOMMUUnit *fallback = NULL;
+
+	for (ARC_IOMMUUnit *unit = iommu_units; unit != NULL; unit = unit->next) {
+		if (unit->segment != segment) {
+			continue;
+		}
+
+		for (ARC_IOMMURange *range = unit->ranges; range != NULL; range = range->next) {
+			if (range->first <= bdf && bdf <= range->last) {
+				return unit->disabled ? NULL : unit;
+			}
+		}
+
+		if (unit->include_all && fallback == NULL) {
+			fallback = unit;
+		}
+	}
+
+	return (fallback == NULL || fallback->disabled) ? NULL : fallback;
+}
+
+static ARC_IOMMUUnit *iommu_add_unit(int type, uint16_t segment, uint64_t base) {
+	ARC_IOMMUUnit *unit = calloc(1, sizeof(*unit));
+
+	if (unit == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate IOMMU unit\n");
+		return NULL;
+	}
+
+	unit->type = type;
+	unit->segment = segment;
+	unit->base = base;
+	unit->page_sizes = ARC_IOMMU_PAGE_4K;
+	// Domain 0 is reserved by VT-d in caching mode
+	unit->next_domain = 1;
+
+	if (iommu_units_tail == NULL) {
+		iommu_units = unit;
+	} else {
+		iommu_units_tail->next = unit;
+	}
+
+	iommu_units_tail = unit;
+
+	return unit;
+}
+
+static int iommu_add_range(ARC_IOMMUUnit *unit, uint16_t first, uint16_t last) {
+	ARC_IOMMURange *range = alloc(sizeof(*range));
+
+	if (range == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate IOMMU range\n");
+		return -1;
+	}
+
+	range->first = first;
+	range->last = last;
+	range->next = unit->ranges;
+	unit->ranges = range;
+
+	return 0;
+}
+
+// Follow the path of a device scope through bridges
+static void iommu_add_dmar_scope(ARC_IOMMUUnit *unit, ARC_DMARScope *scope) {
+	int hops = (scope->length - sizeof(ARC_DMARScope)) / sizeof(scope->path[0]);
+
+	if (hops == 0) {
+		return;
+	}
+
+	uint8_t bus = scope->start_bus;
+
+	for (int i = 0; i < hops - 1; i++) {
+		uint32_t buses = pci_read(unit->segment, bus, scope->path[i].device, scope->path[i].function, IOMMU_PCI_BRIDGE_BUSES);
+		bus = MASKED_READ(buses, 8, 0xFF);
+	}
+
+	uint8_t device = scope->path[hops - 1].device;
+	uint8_t function = scope->path[hops - 1].function;
+	uint16_t bdf = ARC_IOMMU_BDF(bus, device, function);
+
+	switch (scope->type) {
+		case ARC_DMAR_SCOPE_TYPE_ENDPOINT: {
+			iommu_add_range(unit, bdf, bdf);
+			break;
+		}
+
+		case ARC_DMAR_SCOPE_TYPE_BRIDGE: {
+			uint32_t buses = pci_read(unit->segment, bus, device, function, IOMMU_PCI_BRIDGE_BUSES);
+			uint8_t secondary = MASKED_READ(buses, 8, 0xFF);
+			uint8_t subordinate = MASKED_READ(buses, 16, 0xFF);
+
+			iommu_add_range(unit, bdf, bdf);
+			iommu_add_range(unit, ARC_IOMMU_BDF(secondary, 0, 0), ARC_IOMMU_BDF(subordinate, 31, 7));
+			break;
+		}
+
+		default: {
+			// I/O APICs, HPETs and namespace devices only matter for
+			// interrupt remapping
+			break;
+		}
+	}
+}
+
+// Check a VT-d unit can walk the tables built here, the walks of units which do
+// not snoop would need every table write flushed from the cache
+static int iommu_probe_vtd(uint64_t base, uint32_t *page_sizes) {
+	uint32_t attributes = (ARC_PAGER_PAT_UC << ARC_PAGER_PAT) | (1 << ARC_PAGER_NX) | (1 << ARC_PAGER_RW);
+
+	// The registers may already be mapped as part of the HHDM, in which
+	// case they are remapped unless they are already uncached
+	ARC_PagerTranslation translation = { 0 };
+	bool mapped = pager_translate((void *)Arc_KernelPageTables, ARC_PHYS_TO_HHDM(base), &translation) == 0;
+
+	if (mapped && ((translation.attributes >> ARC_PAGER_PAT) & 0b111) != ARC_PAGER_PAT_UC) {
+		attributes |= 1 << ARC_PAGER_OVW;
+		mapped = false;
+	}
+
+	if (!mapped && pager_map((void *)Arc_KernelPageTables, ARC_PHYS_TO_HHDM(base), base, IOMMU_TABLE_SIZE, attributes) != 0) {
+		ARC_DEBUG(ERR, "Failed to map IOMMU at 0x%"PRIx64"\n", base);
+		return -1;
+	}
+
+	volatile uint64_t *registers = (volatile uint64_t *)ARC_PHYS_TO_HHDM(base);
+	uint64_t cap = registers[IOMMU_VTD_REG_CAP / sizeof(uint64_t)];
+	uint64_t ecap = registers[IOMMU_VTD_REG_ECAP / sizeof(uint64_t)];
+
+	if (!(IOMMU_VTD_CAP_SAGAW(cap) & IOMMU_VTD_SAGAW_4_LEVEL)) {
+		ARC_DEBUG(ERR, "IOMMU at 0x%"PRIx64" does not support 4 level tables, leaving it disabled\n", base);
+		return -1;
+	}
+
+	if (!(ecap & IOMMU_VTD_ECAP_COHERENT)) {
+		ARC_DEBUG(ERR, "IOMMU at 0x%"PRIx64" does not snoop its tables, leaving it disabled\n", base);
+		return -1;
+	}
+
+	uint64_t sllps = IOMMU_VTD_CAP_SLLPS(cap);
+
+	if (sllps & (1 << 0)) {
+		*page_sizes |= ARC_IOMMU_PAGE_2M;
+	}
+
+	if (sllps & (1 << 1)) {
+		*page_sizes |= ARC_IOMMU_PAGE_1G;
+	}
+
+	return 0;
+}
+
+static int iommu_parse_dmar() {
+	ARC_DMARIterator it = NULL;
+	ARC_DMARDrhd *drhd = NULL;
+	int count = 0;
+
+	while ((drhd = acpi_get_next_dmar_entry(ARC_DMAR_ENTRY_TYPE_DRHD, &it)) != NULL) {
+		ARC_IOMMUUnit *unit = iommu_add_unit(ARC_IOMMU_TYPE_VTD, drhd->segment, drhd->base);
+
+		if (unit == NULL) {
+			return -1;
+		}
+
+		// Kept so that its devices are not mistaken for those of an
+		// include all unit
+		unit->disabled = iommu_probe_vtd(drhd->base, &unit->page_sizes) != 0;
+		unit->include_all = (drhd->flags & ARC_DMAR_DRHD_INCLUDE_PCI_ALL) != 0;
+
+		ARC_DMARScope *scope = NULL;
+		while ((scope = acpi_get_next_dmar_scope(it, scope)) != NULL) {
+			iommu_add_dmar_scope(unit, scope);
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+static int iommu_parse_ivrs() {
+	// IVHDs of different types may describe the same unit, only the most
+	// detailed type present is used
+	static const int types[] = { ARC_IVRS_ENTRY_TYPE_IVHD40, ARC_IVRS_ENTRY_TYPE_IVHD11, ARC_IVRS_ENTRY_TYPE_IVHD10 };
+	ARC_IVRSIterator it = NULL;
+	int type = -1;
+
+	for (size_t i = 0; i < sizeof(types) / sizeof(*types) && type == -1; i++) {
+		if (acpi_get_next_ivrs_entry(types[i], &it) != NULL) {
+			type = types[i];
+			it = NULL;
+		}
+	}
+
+	ARC_IVRSIvhd *ivhd = NULL;
+	int count = 0;
+
+	while (type != -1 && (ivhd = acpi_get_next_ivrs_entry(type, &it)) != NULL) {
+		ARC_IOMMUUnit *unit = iommu_add_unit(ARC_IOMMU_TYPE_AMDVI, ivhd->segment, ivhd->base);
+
+		if (unit == NULL) {
+			return -1;
+		}
+
+		unit->device_id = ivhd->device_id;
+		unit->page_sizes |= ARC_IOMMU_PAGE_2M | ARC_IOMMU_PAGE_1G;
+
+		ARC_IVRSDevice *device = NULL;
+		int start = -1;
+
+		while ((device = acpi_get_next_ivrs_device(it, device)) != NULL) {
+			switch (device->type) {
+				case ARC_IVRS_DEVICE_ALL: {
+					iommu_add_range(unit, 0, UINT16_MAX);
+					break;
+				}
+
+				case ARC_IVRS_DEVICE_SELECT:
+				case ARC_IVRS_DEVICE_ALIAS:
+				case ARC_IVRS_DEVICE_EXT: {
+					iommu_add_range(unit, device->id, device->id);
+					break;
+				}
+
+				case ARC_IVRS_DEVICE_RANGE_START:
+				case ARC_IVRS_DEVICE_ALIAS_START:
+				case ARC_IVRS_DEVICE_EXT_START: {
+					start = device->id;
+					break;
+				}
+
+				case ARC_IVRS_DEVICE_RANGE_END: {
+					if (start != -1 && start <= device->id) {
+						iommu_add_range(unit, start, device->id);
+					}
+
+					start = -1;
+					break;
+				}
+			}
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+static uint64_t *iommu_alloc_table() {
+	uint64_t *table = alloc(IOMMU_TABLE_SIZE);
+
+	if (table == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate IOMMU table\n");
+		return NULL;
+	}
+
+	if (((uintptr_t)table & (IOMMU_TABLE_SIZE - 1)) != 0) {
+		ARC_DEBUG(ERR, "IOMMU table is not page aligned\n");
+		free(table);
+		return NULL;
+	}
+
+	memset(table, 0, IOMMU_TABLE_SIZE);
+
+	return table;
+}
+
+static bool iommu_present(int type, uint64_t entry) {
+	if (type == ARC_IOMMU_TYPE_VTD) {
+		return (entry & (IOMMU_VTD_READ | IOMMU_VTD_WRITE)) != 0;
+	}
+
+	return (entry & IOMMU_AMD_PRESENT) != 0;
+}
+
+static bool iommu_is_page(int type, uint64_t entry, int level) {
+	if (level == 1) {
+		return true;
+	}
+
+	if (type == ARC_IOMMU_TYPE_VTD) {
+		return (entry & IOMMU_VTD_LARGE) != 0;
+	}
+
+	return (entry & IOMMU_AMD_NEXT_LEVEL_MASK) == 0;
+}
+
+// Entry pointing at a table of the next level
+static uint64_t iommu_table_entry(int type, uint64_t phys, int level) {
+	if (type == ARC_IOMMU_TYPE_VTD) {
+		return phys | IOMMU_VTD_READ | IOMMU_VTD_WRITE;
+	}
+
+	return phys | IOMMU_AMD_PRESENT | IOMMU_AMD_NEXT_LEVEL(level - 1) | IOMMU_AMD_READ | IOMMU_AMD_WRITE;
+}
+
+static uint64_t iommu_page_entry(int type, uint64_t phys, int level, uint32_t flags) {
+	if (type == ARC_IOMMU_TYPE_VTD) {
+		return phys | (level > 1 ? IOMMU_VTD_LARGE : 0)
+		       | ((flags & ARC_IOMMU_READ) ? IOMMU_VTD_READ : 0)
+		       | ((flags & ARC_IOMMU_WRITE) ? IOMMU_VTD_WRITE : 0);
+	}
+
+	return phys | IOMMU_AMD_PRESENT
+	       | ((flags & ARC_IOMMU_READ) ? IOMMU_AMD_READ : 0)
+	       | ((flags & ARC_IOMMU_WRITE) ? IOMMU_AMD_WRITE : 0);
+}
+
+static uint32_t iommu_page_flags(int type, uint64_t entry) {
+	if (type == ARC_IOMMU_TYPE_VTD) {
+		return ((entry & IOMMU_VTD_READ) ? ARC_IOMMU_READ : 0) | ((entry & IOMMU_VTD_WRITE) ? ARC_IOMMU_WRITE : 0);
+	}
+
+	return ((entry & IOMMU_AMD_READ) ? ARC_IOMMU_READ : 0) | ((entry & IOMMU_AMD_WRITE) ? ARC_IOMMU_WRITE : 0);
+}
+
+// Replace a large page with a table of smaller pages mapping the same memory
+static int iommu_split(ARC_IOMMUDomain *domain, uint64_t *entry, int level) {
+	uint64_t *table = iommu_alloc_table();
+
+	if (table == NULL) {
+		return -1;
+	}
+
+	int type = domain->unit->type;
+	uint64_t phys = *entry & IOMMU_ADDRESS_MASK;
+	uint32_t flags = iommu_page_flags(type, *entry);
+
+	for (int i = 0; i < IOMMU_TABLE_ENTRIES; i++) {
+		table[i] = iommu_page_entry(type, phys + i * IOMMU_LEVEL_SIZE(level - 1), level - 1, flags);
+	}
+
+	__atomic_store_n(entry, iommu_table_entry(type, ARC_HHDM_TO_PHYS(table), level), __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+// Get the entry translating iova at level, creating tables on the way. Fails
+// if a larger page already translates iova
+static uint64_t *iommu_walk(ARC_IOMMUDomain *domain, uint64_t iova, int level) {
+	int type = domain->unit->type;
+	uint64_t *table = domain->root;
+
+	for (int current = IOMMU_LEVELS; current > level; current--) {
+		uint64_t *entry = &table[IOMMU_LEVEL_INDEX(iova, current)];
+
+		if (!iommu_present(type, *entry)) {
+			uint64_t *next = iommu_alloc_table();
+
+			if (next == NULL) {
+				return NULL;
+			}
+
+			__atomic_store_n(entry, iommu_table_entry(type, ARC_HHDM_TO_PHYS(next), current), __ATOMIC_RELEASE);
+		} else if (iommu_is_page(type, *entry, current)) {
+			return NULL;
+		}
+
+		table = (uint64_t *)ARC_PHYS_TO_HHDM(*entry & IOMMU_ADDRESS_MASK);
+	}
+
+	return &table[IOMMU_LEVEL_INDEX(iova, level)];
+}
+
+static void iommu_extend_flush(ARC_IOMMUDomain *domain, uint64_t address, uint64_t size) {
+	if (address < domain->flush_start) {
+		domain->flush_start = address;
+	}
+
+	if (address + size > domain->flush_end) {
+		domain->flush_end = address + size;
+	}
+}
+
+static bool iommu_table_empty(int type, uint64_t *table, int level) {
+	for (int i = 0; i < IOMMU_TABLE_ENTRIES; i++) {
+		if (!iommu_present(type, table[i])) {
+			continue;
+		}
+
+		if (iommu_is_page(type, table[i], level)
+		    || !iommu_table_empty(type, (uint64_t *)ARC_PHYS_TO_HHDM(table[i] & IOMMU_ADDRESS_MASK), level - 1)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Detach the table an entry points to if nothing is mapped through it, so
+// that a larger page can take its place. The unit may still walk the table
+// until the next flush, which frees it
+static int iommu_retire_table(ARC_IOMMUDomain *domain, uint64_t iova, uint64_t *entry, int level) {
+	int type = domain->unit->type;
+	uint64_t *table = (uint64_t *)ARC_PHYS_TO_HHDM(*entry & IOMMU_ADDRESS_MASK);
+
+	if (level == 1 || iommu_is_page(type, *entry, level) || !iommu_table_empty(type, table, level - 1)) {
+		return -1;
+	}
+
+	struct iommu_retired *retired = alloc(sizeof(*retired));
+
+	if (retired == NULL) {
+		return -1;
+	}
+
+	retired->table = table;
+	retired->level = level - 1;
+	retired->next = domain->retired;
+	domain->retired = retired;
+
+	__atomic_store_n(entry, 0, __ATOMIC_RELEASE);
+	iommu_extend_flush(domain, iova & ~(IOMMU_LEVEL_SIZE(level) - 1), IOMMU_LEVEL_SIZE(level));
+
+	return 0;
+}
+
+// Largest page that can map the start of a range
+static int iommu_page_level(uint32_t page_sizes, uint64_t iova, uint64_t phys, uint64_t size) {
+	if ((page_sizes & ARC_IOMMU_PAGE_1G) && ((iova | phys) & (IOMMU_LEVEL_SIZE(3) - 1)) == 0 && size >= IOMMU_LEVEL_SIZE(3)) {
+		return 3;
+	}
+
+	if ((page_sizes & ARC_IOMMU_PAGE_2M) && ((iova | phys) & (IOMMU_LEVEL_SIZE(2) - 1)) == 0 && size >= IOMMU_LEVEL_SIZE(2)) {
+		return 2;
+	}
+
+	return 1;
+}
+
+static void iommu_free_table(int type, uint64_t *table, int level) {
+	for (int i = 0; level > 1 && i < IOMMU_TABLE_ENTRIES; i++) {
+		if (iommu_present(type, table[i]) && !iommu_is_page(type, table[i], level)) {
+			iommu_free_table(type, (uint64_t *)ARC_PHYS_TO_HHDM(table[i] & IOMMU_ADDRESS_MASK), level - 1);
+		}
+	}
+
+	free(table);
+}
+
+ARC_IOMMUDomain *iommu_create_domain(ARC_IOMMUUnit *unit) {
+	if (unit == NULL || unit->disabled) {
+		return NULL;
+	}
+
+	uint16_t id = __atomic_fetch_add(&unit->next_domain, 1, __ATOMIC_RELAXED);
+
+	if (id == 0) {
+		ARC_DEBUG(ERR, "Out of IOMMU domains\n");
+		return NULL;
+	}
+
+	ARC_IOMMUDomain *domain = alloc(sizeof(*domain));
+
+	if (domain == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate IOMMU domain\n");
+		return NULL;
+	}
+
+	domain->root = iommu_alloc_table();
+
+	if (domain->root == NULL) {
+		free(domain);
+		return NULL;
+	}
+
+	domain->unit = unit;
+	domain->id = id;
+	domain->root_phys = ARC_HHDM_TO_PHYS(domain->root);
+	domain->flush_start = UINT64_MAX;
+	domain->flush_end = 0;
+	domain->retired = NULL;
+	init_static_spinlock(&domain->lock);
+
+	return domain;
+}
+
+int iommu_destroy_domain(ARC_IOMMUDomain *domain) {
+	if (domain == NULL) {
+		return -1;
+	}
+
+	iommu_flush(domain);
+	iommu_free_table(domain->unit->type, domain->root, IOMMU_LEVELS);
+	free(domain);
+
+	return 0;
+}
+
+int iommu_unmap(ARC_IOMMUDomain *domain, uint64_t iova, size_t size) {
+	if (domain == NULL || ((iova | size) & (IOMMU_LEVEL_SIZE(1) - 1)) != 0) {
+		return -1;
+	}
+
+	int type = domain->unit->type;
+	int r = 0;
+
+	spinlock_lock(&domain->lock);
+
+	for (uint64_t done = 0; done < size;) {
+		uint64_t address = iova + done;
+		uint64_t *table = domain->root;
+		uint64_t *entry = NULL;
+		int level = IOMMU_LEVELS;
+
+		// Find the page translating address
+		for (;; level--) {
+			entry = &table[IOMMU_LEVEL_INDEX(address, level)];
+
+			if (!iommu_present(type, *entry) || iommu_is_page(type, *entry, level)) {
+				break;
+			}
+
+			table = (uint64_t *)ARC_PHYS_TO_HHDM(*entry & IOMMU_ADDRESS_MASK);
+		}
+
+		uint64_t span = IOMMU_LEVEL_SIZE(level);
+		uint64_t offset = address & (span - 1);
+
+		if (!iommu_present(type, *entry)) {
+			done += span - offset;
+			continue;
+		}
+
+		// Only part of a large page is to be unmapped
+		if (offset != 0 || size - done < span) {
+			if (iommu_split(domain, entry, level) != 0) {
+				r = -1;
+				break;
+			}
+
+			continue;
+		}
+
+		__atomic_store_n(entry, 0, __ATOMIC_RELEASE);
+		iommu_extend_flush(domain, address, span);
+
+		done += span;
+	}
+
+	spinlock_unlock(&domain->lock);
+
+	return r;
+}
+
+int iommu_map(ARC_IOMMUDomain *domain, uint64_t iova, uint64_t phys, size_t size, uint32_t flags) {
+	if (domain == NULL || size == 0 || ((iova | phys | size) & (IOMMU_LEVEL_SIZE(1) - 1)) != 0) {
+		return -1;
+	}
+
+	int type = domain->unit->type;
+	uint64_t done = 0;
+	int r = 0;
+
+	spinlock_lock(&domain->lock);
+
+	while (done < size) {
+		int level = iommu_page_level(domain->unit->page_sizes, iova + done, phys + done, size - done);
+		uint64_t *entry = iommu_walk(domain, iova + done, level);
+
+		if (entry != NULL && iommu_present(type, *entry)) {
+			iommu_retire_table(domain, iova + done, entry, level);
+		}
+
+		if (entry == NULL || iommu_present(type, *entry)) {
+			r = -1;
+			break;
+		}
+
+		__atomic_store_n(entry, iommu_page_entry(type, phys + done, level, flags), __ATOMIC_RELEASE);
+		done += IOMMU_LEVEL_SIZE(level);
+	}
+
+	spinlock_unlock(&domain->lock);
+
+	if (r != 0) {
+		ARC_DEBUG(ERR, "Failed to map 0x%"PRIx64" -> 0x%"PRIx64" (%lu)\n", iova + done, phys + done, size - done);
+		iommu_unmap(domain, iova, done);
+	}
+
+	return r;
+}
+
+int iommu_flush(ARC_IOMMUDomain *domain) {
+	if (domain == NULL) {
+		return -1;
+	}
+
+	spinlock_lock(&domain->lock);
+	uint64_t start = domain->flush_start;
+	uint64_t end = domain->flush_end;
+	struct iommu_retired *retired = domain->retired;
+	domain->flush_start = UINT64_MAX;
+	domain->flush_end = 0;
+	domain->retired = NULL;
+	spinlock_unlock(&domain->lock);
+
+	if (end <= start) {
+		return 0;
+	}
+
+	int r = iommu_invalidate(domain->unit, domain->id, start, end - start);
+
+	while (retired != NULL) {
+		struct iommu_retired *next = retired->next;
+		iommu_free_table(domain->unit->type, retired->table, retired->level);
+		free(retired);
+		retired = next;
+	}
+
+	return r;
+}
+
+int init_iommu() {
+	int count = iommu_parse_dmar();
+
+	if (count == 0) {
+		count = iommu_parse_ivrs();
+	}
+
+	if (count <= 0) {
+		ARC_DEBUG(INFO, "No IOMMUs\n");
+		return count;
+	}
+
+	for (ARC_IOMMUUnit *unit = iommu_units; unit != NULL; unit = unit->next) {
+		ARC_DEBUG(INFO, "IOMMU at 0x%"PRIx64" (%s) on segment %d%s%s, pages:%s%s%s\n", unit->base,
+		          unit->type == ARC_IOMMU_TYPE_VTD ? "VT-d" : "AMD-Vi", unit->segment,
+		          unit->include_all ? ", all devices" : "",
+		          unit->disabled ? ", disabled" : "",
+		          (unit->page_sizes & ARC_IOMMU_PAGE_4K) ? " 4K" : "",
+		          (unit->page_sizes & ARC_IOMMU_PAGE_2M) ? " 2M" : "",
+		          (unit->page_sizes & ARC_IOMMU_PAGE_1G) ? " 1G" : "");
+	}
+
+	return 0;
+}
@@ -0,0 +1,755 @@
+/**
+ * @file pager.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * Architecture neutral frontend of the pager. Changes are made through the
+ * backend the architecture installs, gathered into batches and invalidated
+ * once per batch. Reserved ranges are filled on demand.
+*/
+#include "arch/pager.h"
+#include "arch/smp.h"
+#include "global.h"
+#include "mm/allocator.h"
+
+#include <stdbool.h>
+
+#define PAGER_PAGE_SIZE 0x1000
+#define PAGER_LARGE_PAGE_SIZE 0x200000
+#define PAGER_ALIGN_DOWN(__value, __size) ((__value) & ~((uintptr_t)(__size) - 1))
+
+// Attributes describing a mapping, rather than how to make it
+#define PAGER_STATE_ATTRIBUTES ((0b111 << ARC_PAGER_PAT) | (1 << ARC_PAGER_US) | (1 << ARC_PAGER_NX) | (1 << ARC_PAGER_RW))
+
+// Range of a pager_fly_map with ARC_PAGER_RESERVE, filled on faults
+struct pager_reservation {
+	struct pager_reservation *next;
+	void *page_tables;
+	uintptr_t start;
+	uintptr_t end;
+	uint32_t attributes;
+	int hint;
+	size_t faults;
+	size_t pages;
+	// 1: Pages are being mapped into the range outside of the lock, the
+	//    reservation is neither filled again nor released until done
+	bool filling;
+};
+
+static ARC_PagerBackend *pager_backend = NULL;
+static struct pager_reservation *pager_reservations = NULL;
+static uint32_t pager_reservations_lock = 0;
+
+int pager_set_backend(ARC_PagerBackend *backend) {
+	if (backend == NULL) {
+		ARC_DEBUG(ERR, "No backend given\n");
+		return -1;
+	}
+
+	pager_backend = backend;
+
+	ARC_DEBUG(INFO, "Using %d level page tables\n", backend->levels);
+
+	return 0;
+}
+
+static inline void pager_relax() {
+#ifdef ARC_TARGET_ARCH_X86_64
+	__builtin_ia32_pause();
+#endif
+}
+
+static void pager_lock_reservations() {
+	while (__atomic_exchange_n(&pager_reservations_lock, 1, __ATOMIC_ACQUIRE) != 0) {
+		pager_relax();
+	}
+}
+
+static void pager_unlock_reservations() {
+	__atomic_store_n(&pager_reservations_lock, 0, __ATOMIC_RELEASE);
+}
+
+// pager_reservations_lock must be held
+static struct pager_reservation *pager_find_reservation(void *page_tables, uintptr_t virtual) {
+	for (struct pager_reservation *reservation = pager_reservations; reservation != NULL; reservation = reservation->next) {
+		if (reservation->page_tables == page_tables && virtual >= reservation->start && virtual < reservation->end) {
+			return reservation;
+		}
+	}
+
+	return NULL;
+}
+
+// Claim the reservation holding virtual for a fill, waiting out any fill of it
+// already in progress. pager_reservations_lock must be held, it is dropped
+// while waiting
+static struct pager_reservation *pager_claim_reservation(void *page_tables, uintptr_t virtual) {
+	struct pager_reservation *reservation = NULL;
+
+	while ((reservation = pager_find_reservation(page_tables, virtual)) != NULL && reservation->filling) {
+		pager_unlock_reservations();
+		pager_relax();
+		pager_lock_reservations();
+	}
+
+	if (reservation != NULL) {
+		reservation->filling = true;
+	}
+
+	return reservation;
+}
+
+// pager_reservations_lock must be held
+static bool pager_range_filling(void *page_tables, uintptr_t start, uintptr_t end) {
+	for (struct pager_reservation *reservation = pager_reservations; reservation != NULL; reservation = reservation->next) {
+		if (reservation->page_tables == page_tables && reservation->start < end && start < reservation->end
+		    && reservation->filling) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int pager_reserve(void *page_tables, uintptr_t virtual, size_t size, uint32_t attributes) {
+	struct pager_reservation *reservation = alloc(sizeof(*reservation));
+
+	if (reservation == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate reservation\n");
+		return -1;
+	}
+
+	*reservation = (struct pager_reservation){
+	        .page_tables = page_tables,
+	        .start = PAGER_ALIGN_DOWN(virtual, PAGER_PAGE_SIZE),
+	        .end = PAGER_ALIGN_DOWN(virtual + size + PAGER_PAGE_SIZE - 1, PAGER_PAGE_SIZE),
+	        .attributes = attributes & ~(1 << ARC_PAGER_RESERVE),
+	        .hint = ARC_PAGER_HINT_NORMAL,
+	};
+
+	pager_lock_reservations();
+
+	for (struct pager_reservation *other = pager_reservations; other != NULL; other = other->next) {
+		if (other->page_tables == page_tables && other->start < reservation->end && reservation->start < other->end) {
+			pager_unlock_reservations();
+			ARC_DEBUG(ERR, "Reservation of 0x%"PRIx64" overlaps another\n", (uint64_t)virtual);
+			free(reservation);
+			return -1;
+		}
+	}
+
+	reservation->next = pager_reservations;
+	pager_reservations = reservation;
+
+	pager_unlock_reservations();
+
+	return 0;
+}
+
+// Drop the reservations of a range, trimming or splitting those crossing its
+// edges
+static int pager_release(void *page_tables, uintptr_t start, uintptr_t end) {
+	// Allocated up front, as a release in the middle of a reservation splits
+	// it in two
+	struct pager_reservation *spare = alloc(sizeof(*spare));
+	struct pager_reservation *released = NULL;
+	int ret = 0;
+
+	pager_lock_reservations();
+
+	// Pages a fill maps after the range is unmapped would be left behind
+	while (pager_range_filling(page_tables, start, end)) {
+		pager_unlock_reservations();
+		pager_relax();
+		pager_lock_reservations();
+	}
+
+	struct pager_reservation **link = &pager_reservations;
+
+	while (*link != NULL) {
+		struct pager_reservation *reservation = *link;
+
+		if (reservation->page_tables != page_tables || reservation->end <= start || end <= reservation->start) {
+			link = &reservation->next;
+			continue;
+		}
+
+		if (start <= reservation->start && end >= reservation->end) {
+			*link = reservation->next;
+			reservation->next = released;
+			released = reservation;
+			continue;
+		}
+
+		if (start > reservation->start && end < reservation->end) {
+			if (spare == NULL) {
+				ARC_DEBUG(ERR, "Failed to split reservation\n");
+				ret = -1;
+				break;
+			}
+
+			*spare = *reservation;
+			spare->start = end;
+			reservation->end = start;
+			reservation->next = spare;
+			spare = NULL;
+		} else if (start <= reservation->start) {
+			reservation->start = end;
+		} else {
+			reservation->end = start;
+		}
+
+		link = &reservation->next;
+	}
+
+	pager_unlock_reservations();
+
+	while (released != NULL) {
+		struct pager_reservation *next = released->next;
+		free(released);
+		released = next;
+	}
+
+	if (spare != NULL) {
+		free(spare);
+	}
+
+	return ret;
+}
+
+// Map new memory to the unmapped pages of a range
+static int pager_fill(void *page_tables, uintptr_t start, uintptr_t end, uint32_t attributes) {
+	if (pager_backend == NULL || pager_backend->fly_map == NULL || pager_backend->translate == NULL) {
+		return -1;
+	}
+
+	ARC_PagerBatch batch;
+	pager_batch_begin(&batch, page_tables);
+
+	uintptr_t run = 0;
+	bool in_run = false;
+	int mapped = 0;
+	int ret = 0;
+
+	for (uintptr_t address = start; address <= end; address += PAGER_PAGE_SIZE) {
+		ARC_PagerTranslation translation = { 0 };
+		bool missing = address < end && pager_backend->translate(page_tables, address, &translation) != 0;
+
+		if (missing && !in_run) {
+			run = address;
+			in_run = true;
+		} else if (!missing && in_run) {
+			ret |= pager_backend->fly_map(&batch, run, address - run, attributes);
+			mapped += (address - run) / PAGER_PAGE_SIZE;
+			in_run = false;
+		}
+	}
+
+	pager_batch_commit(&batch, NULL);
+
+	return ret == 0 ? mapped : -1;
+}
+
+// Done with a claimed reservation, adding the pages the fill mapped
+static void pager_unclaim_reservation(struct pager_reservation *reservation, int mapped) {
+	pager_lock_reservations();
+
+	if (mapped > 0) {
+		reservation->pages += mapped;
+	}
+
+	reservation->filling = false;
+
+	pager_unlock_reservations();
+}
+
+int pager_resolve_fault(void *page_tables, uintptr_t virtual) {
+	pager_lock_reservations();
+
+	struct pager_reservation *reservation = pager_claim_reservation(page_tables, virtual);
+
+	if (reservation == NULL) {
+		pager_unlock_reservations();
+		return 1;
+	}
+
+	uintptr_t page = PAGER_ALIGN_DOWN(virtual, PAGER_PAGE_SIZE);
+	uintptr_t cluster = ARC_PAGER_FAULT_CLUSTER * PAGER_PAGE_SIZE;
+	uintptr_t start = page;
+	uintptr_t end = page + PAGER_PAGE_SIZE;
+
+	switch (reservation->hint) {
+		case ARC_PAGER_HINT_SEQUENTIAL: {
+			end = page + cluster;
+			break;
+		}
+
+		case ARC_PAGER_HINT_RANDOM: {
+			break;
+		}
+
+		default: {
+			start = PAGER_ALIGN_DOWN(page, cluster);
+			end = start + cluster;
+			break;
+		}
+	}
+
+	start = start < reservation->start ? reservation->start : start;
+	end = end > reservation->end ? reservation->end : end;
+	uint32_t attributes = reservation->attributes;
+	reservation->faults++;
+
+	pager_unlock_reservations();
+
+	// Mapped outside of the lock, as it allocates. The claim keeps the range
+	// reserved meanwhile, and a racing fault on it finds the pages mapped
+	// once it gets its turn
+	int mapped = pager_fill(page_tables, start, end, attributes);
+	pager_unclaim_reservation(reservation, mapped);
+
+	if (mapped < 0) {
+		ARC_DEBUG(ERR, "Failed to fill reservation at 0x%"PRIx64"\n", (uint64_t)virtual);
+		return -1;
+	}
+
+	return 0;
+}
+
+int pager_advise(void *page_tables, uintptr_t virtual, int hint, size_t count) {
+	pager_lock_reservations();
+
+	struct pager_reservation *reservation = pager_find_reservation(page_tables, virtual);
+
+	if (reservation == NULL) {
+		pager_unlock_reservations();
+		return -1;
+	}
+
+	reservation->hint = hint;
+
+	if (hint != ARC_PAGER_HINT_POPULATE || count == 0) {
+		pager_unlock_reservations();
+		return 0;
+	}
+
+	reservation = pager_claim_reservation(page_tables, virtual);
+
+	if (reservation == NULL) {
+		// Released while waiting for another fill
+		pager_unlock_reservations();
+		return -1;
+	}
+
+	uintptr_t start = PAGER_ALIGN_DOWN(virtual, PAGER_PAGE_SIZE);
+	uintptr_t end = reservation->end;
+	uint32_t attributes = reservation->attributes;
+
+	pager_unlock_reservations();
+
+	if (count < (end - start) / PAGER_PAGE_SIZE) {
+		end = start + count * PAGER_PAGE_SIZE;
+	}
+
+	int mapped = pager_fill(page_tables, start, end, attributes);
+	pager_unclaim_reservation(reservation, mapped);
+
+	return mapped < 0 ? -1 : 0;
+}
+
+int pager_get_reservation_stats(void *page_tables, uintptr_t virtual, ARC_PagerReservationStats *stats) {
+	if (stats == NULL) {
+		return -1;
+	}
+
+	pager_lock_reservations();
+
+	struct pager_reservation *reservation = pager_find_reservation(page_tables, virtual);
+
+	if (reservation != NULL) {
+		*stats = (ARC_PagerReservationStats){
+		        .virtual = reservation->start,
+		        .size = reservation->end - reservation->start,
+		        .hint = reservation->hint,
+		        .faults = reservation->faults,
+		        .pages = reservation->pages,
+		};
+	}
+
+	pager_unlock_reservations();
+
+	return reservation != NULL ? 0 : -1;
+}
+
+int pager_batch_begin(ARC_PagerBatch *batch, void *page_tables) {
+	if (batch == NULL) {
+		return -1;
+	}
+
+	*batch = (ARC_PagerBatch){ .page_tables = page_tables, .flush_start = UINTPTR_MAX };
+
+	return 0;
+}
+
+void pager_batch_add(ARC_PagerBatch *batch, uintptr_t virtual, size_t size) {
+	if (size == 0) {
+		return;
+	}
+
+	uintptr_t start = virtual & ~(PAGER_PAGE_SIZE - 1);
+	uintptr_t end = (virtual + size + PAGER_PAGE_SIZE - 1) & ~(PAGER_PAGE_SIZE - 1);
+
+	batch->page_count += (end - start) / PAGER_PAGE_SIZE;
+
+	if (start < batch->flush_start) {
+		batch->flush_start = start;
+	}
+
+	if (end > batch->flush_end) {
+		batch->flush_end = end;
+	}
+}
+
+void pager_batch_free_frame(ARC_PagerBatch *batch, void *frame) {
+	*(void **)frame = batch->freed_frames;
+	batch->freed_frames = frame;
+	batch->freed_frame_count++;
+}
+
+void pager_batch_free_table(ARC_PagerBatch *batch, void *table) {
+	*(void **)table = batch->freed_tables;
+	batch->freed_tables = table;
+	batch->freed_table_count++;
+}
+
+int pager_batch_commit(ARC_PagerBatch *batch, void **freed) {
+	if (batch == NULL) {
+		return -1;
+	}
+
+	if (batch->page_count > 0) {
+		size_t span = batch->flush_end - batch->flush_start;
+		int kind = ARC_PAGER_FLUSH_ALL;
+
+		if (span <= ARC_PAGER_BATCH_MAX_PAGES * PAGER_PAGE_SIZE) {
+			kind = ARC_PAGER_FLUSH_PAGES;
+		} else if (span <= ARC_PAGER_BATCH_MAX_RANGE) {
+			kind = ARC_PAGER_FLUSH_RANGE;
+		}
+
+		smp_tlb_shootdown(batch->page_tables, kind, batch->flush_start, batch->flush_end, batch->freed_table_count > 0);
+	}
+
+	int count = batch->freed_frame_count + batch->freed_table_count;
+
+	pager_free_tables(batch->freed_tables);
+
+	if (freed != NULL) {
+		*freed = batch->freed_frames;
+	} else {
+		void *frame = batch->freed_frames;
+
+		while (frame != NULL) {
+			void *next = *(void **)frame;
+			free(frame);
+			frame = next;
+		}
+	}
+
+	pager_batch_begin(batch, batch->page_tables);
+
+	return count;
+}
+
+int pager_batch_map(ARC_PagerBatch *batch, uintptr_t virtual, uintptr_t physical, size_t size, uint32_t attributes) {
+	if (pager_backend == NULL || pager_backend->map == NULL) {
+		return -1;
+	}
+
+	return pager_backend->map(batch, virtual, physical, size, attributes);
+}
+
+int pager_batch_unmap(ARC_PagerBatch *batch, uintptr_t virtual, size_t size) {
+	if (pager_backend == NULL || pager_backend->unmap == NULL) {
+		return -1;
+	}
+
+	return pager_backend->unmap(batch, virtual, size, NULL);
+}
+
+// Whether a large page is mapped across the page boundary at address, such
+// that changing a range starting or ending there splits it
+static bool pager_large_across(void *page_tables, uintptr_t address) {
+	if ((address & (PAGER_LARGE_PAGE_SIZE - 1)) == 0) {
+		return false;
+	}
+
+	ARC_PagerTranslation translation = { 0 };
+
+	return pager_backend->translate(page_tables, address, &translation) == 0 && translation.page_size >= PAGER_LARGE_PAGE_SIZE;
+}
+
+int pager_batch_set_attr(ARC_PagerBatch *batch, uintptr_t virtual, size_t size, uint32_t attributes) {
+	if (pager_backend == NULL || pager_backend->set_attr == NULL) {
+		return -1;
+	}
+
+	if (size == 0) {
+		return 0;
+	}
+
+	if (pager_backend->translate == NULL) {
+		return pager_backend->set_attr(batch, virtual, size, attributes);
+	}
+
+	uintptr_t end = virtual + size;
+	uintptr_t run = 0;
+	bool in_run = false;
+	int ret = 0;
+
+	// Only the large pages straddling the edges are split, and only those
+	// are merged back below, regions mapped with 4K pages on purpose stay so
+	bool split_first = pager_large_across(batch->page_tables, virtual);
+	bool split_last = pager_large_across(batch->page_tables, end);
+
+	// Only hand the backend runs of pages whose attributes change, so that
+	// neither the entries nor the TLB of the rest are touched
+	for (uintptr_t address = virtual; address < end;) {
+		ARC_PagerTranslation translation = { .page_size = PAGER_PAGE_SIZE };
+		bool mapped = pager_backend->translate(batch->page_tables, address, &translation) == 0;
+
+		// Unmapped regions are skipped whole, as far as the backend can tell
+		if (translation.page_size < PAGER_PAGE_SIZE || (translation.page_size & (translation.page_size - 1)) != 0) {
+			translation.page_size = PAGER_PAGE_SIZE;
+		}
+
+		bool changes = mapped && (translation.attributes & PAGER_STATE_ATTRIBUTES) != (attributes & PAGER_STATE_ATTRIBUTES);
+
+		if (changes && !in_run) {
+			run = address;
+			in_run = true;
+		} else if (!changes && in_run) {
+			ret |= pager_backend->set_attr(batch, run, address - run, attributes);
+			in_run = false;
+		}
+
+		address += translation.page_size - (address & (translation.page_size - 1));
+	}
+
+	if (in_run) {
+		ret |= pager_backend->set_attr(batch, run, end - run, attributes);
+	}
+
+	// Merge the split pages back if the change made their neighbours equal
+	// again
+	if (pager_backend->promote != NULL && (attributes & (1 << ARC_PAGER_4K)) == 0) {
+		uintptr_t first = PAGER_ALIGN_DOWN(virtual, PAGER_LARGE_PAGE_SIZE);
+		uintptr_t last = PAGER_ALIGN_DOWN(end, PAGER_LARGE_PAGE_SIZE);
+
+		if (split_first) {
+			pager_backend->promote(batch, first, PAGER_LARGE_PAGE_SIZE);
+		}
+
+		if (split_last && (last != first || !split_first)) {
+			pager_backend->promote(batch, last, PAGER_LARGE_PAGE_SIZE);
+		}
+	}
+
+	return ret == 0 ? 0 : -1;
+}
+
+void *pager_create_page_tables() {
+	if (pager_backend == NULL || pager_backend->create == NULL) {
+		return NULL;
+	}
+
+	return pager_backend->create();
+}
+
+int pager_delete_page_tables(void *page_tables) {
+	if (pager_backend == NULL || pager_backend->destroy == NULL) {
+		return -1;
+	}
+
+	ARC_PagerBatch batch;
+	pager_batch_begin(&batch, page_tables);
+
+	int ret = pager_backend->destroy(&batch);
+
+	// Lazy processors may still have the tables loaded, move them off before
+	// the tables go back to the pool. This flushes every processor that had
+	// them loaded, so the changed ranges need no shootdown of their own
+	smp_tlb_release(page_tables);
+	pager_release(page_tables, 0, UINTPTR_MAX);
+	batch.page_count = 0;
+	pager_batch_commit(&batch, NULL);
+
+	return ret;
+}
+
+int pager_map(void *page_tables, uintptr_t virtual, uintptr_t physical, size_t size, uint32_t attributes) {
+	ARC_PagerBatch batch;
+	pager_batch_begin(&batch, page_tables);
+
+	int ret = pager_batch_map(&batch, virtual, physical, size, attributes);
+	pager_batch_commit(&batch, NULL);
+
+	return ret;
+}
+
+int pager_unmap(void *page_tables, uintptr_t virtual, size_t size, void **physical) {
+	if (pager_backend == NULL || pager_backend->unmap == NULL) {
+		return -1;
+	}
+
+	ARC_PagerBatch batch;
+	pager_batch_begin(&batch, page_tables);
+
+	int ret = pager_backend->unmap(&batch, virtual, size, physical);
+	pager_batch_commit(&batch, NULL);
+
+	return ret;
+}
+
+int pager_fly_map(void *page_tables, uintptr_t virtual, size_t size, uint32_t attributes) {
+	if (pager_backend == NULL || pager_backend->fly_map == NULL) {
+		return -1;
+	}
+
+	if ((attributes & (1 << ARC_PAGER_RESERVE)) != 0) {
+		return pager_reserve(page_tables, virtual, size, attributes);
+	}
+
+	ARC_PagerBatch batch;
+	pager_batch_begin(&batch, page_tables);
+
+	int ret = pager_backend->fly_map(&batch, virtual, size, attributes);
+	pager_batch_commit(&batch, NULL);
+
+	return ret;
+}
+
+int pager_fly_unmap(void *page_tables, uintptr_t virtual, size_t size) {
+	if (pager_backend == NULL || pager_backend->fly_unmap == NULL) {
+		return -1;
+	}
+
+	pager_release(page_tables, virtual, virtual + size);
+
+	ARC_PagerBatch batch;
+	pager_batch_begin(&batch, page_tables);
+
+	int ret = pager_backend->fly_unmap(&batch, virtual, size);
+	pager_batch_commit(&batch, NULL);
+
+	return ret;
+}
+
+int pager_set_attr(void *page_tables, uintptr_t virtual, size_t size, uint32_t attributes) {
+	ARC_PagerBatch batch;
+	pager_batch_begin(&batch, page_tables);
+
+	int ret = pager_batch_set_attr(&batch, virtual, size, attributes);
+	pager_batch_commit(&batch, NULL);
+
+	return ret;
+}
+
+int pager_promote(void *page_tables, uintptr_t virtual, size_t size) {
+	if (pager_backend == NULL || pager_backend->promote == NULL) {
+		return -1;
+	}
+
+	ARC_PagerBatch batch;
+	pager_batch_begin(&batch, page_tables);
+
+	int ret = pager_backend->promote(&batch, virtual, size);
+	pager_batch_commit(&batch, NULL);
+
+	return ret;
+}
+
+int pager_clone(void *dest, void *src, uintptr_t virt_src, uintptr_t virt_dest, size_t size, uint32_t flags) {
+	if (pager_backend == NULL || pager_backend->clone == NULL) {
+		return -1;
+	}
+
+	ARC_PagerBatch dest_batch;
+	ARC_PagerBatch src_batch;
+	pager_batch_begin(&dest_batch, dest);
+	pager_batch_begin(&src_batch, src);
+
+	int ret = pager_backend->clone(&dest_batch, &src_batch, virt_src, virt_dest, size, flags);
+
+	// Copy-on-write takes write access away from src, which must be seen
+	// before either side writes
+	pager_batch_commit(&src_batch, NULL);
+	pager_batch_commit(&dest_batch, NULL);
+
+	return ret;
+}
+
+int pager_resolve_cow(void *page_tables, uintptr_t virtual) {
+	if (pager_backend == NULL || pager_backend->resolve_cow == NULL) {
+		return -1;
+	}
+
+	ARC_PagerBatch batch;
+	pager_batch_begin(&batch, page_tables);
+
+	int ret = pager_backend->resolve_cow(&batch, virtual);
+	pager_batch_commit(&batch, NULL);
+
+	return ret;
+}
+
+int pager_translate(void *page_tables, uintptr_t virtual, ARC_PagerTranslation *translation) {
+	if (pager_backend == NULL || pager_backend->translate == NULL || translation == NULL) {
+		return -1;
+	}
+
+	return pager_backend->translate(page_tables, virtual, translation);
+}
+
+int pager_get_stats(void *page_tables, ARC_PagerStats *stats) {
+	if (pager_backend == NULL || pager_backend->get_stats == NULL || stats == NULL) {
+		return -1;
+	}
+
+	return pager_backend->get_stats(page_tables, stats);
+}
+
+void pager_flush_local(int kind, uintptr_t start, uintptr_t end) {
+	if (pager_backend == NULL || pager_backend->flush_local == NULL) {
+		return;
+	}
+
+	pager_backend->flush_local(kind, start, end);
+}
+
+void pager_load_local(void *page_tables, uint32_t tag, bool flush) {
+	if (pager_backend == NULL || pager_backend->load_local == NULL) {
+		return;
+	}
+
+	pager_backend->load_local(page_tables, tag, flush);
+}
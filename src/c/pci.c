@@ -26,8 +26,11 @@
 */
 #include "arch/acpi/acpi.h"
 #include "arch/acpi/table.h"
+#include "arch/iommu.h"
 #include "arch/io/port.h"
+#include "arch/numa.h"
 #include "arch/pci.h"
+#include "arch/snapshot.h"
 #include "drivers/resource.h"
 #include "global.h"
 #include "mm/allocator.h"
@@ -136,6 +139,7 @@ ARC_PCIHeaderMeta *pci_read_header(uint16_t segment, uint8_t bus, uint8_t device
 
 	ret->header = header;
 
+	ret->numa_node = ARC_NUMA_NO_NODE;
 	ret->segment = segment;
 	ret->bus = bus;
 	ret->device = device;
@@ -191,6 +195,7 @@ ARC_PCIHeaderMeta *pci_get_mmio_header(uint16_t segment, uint8_t bus, uint8_t de
 	memset(ret, 0, sizeof(*ret));
 
 	ret->is_mmio = true;
+	ret->numa_node = ARC_NUMA_NO_NODE;
 	ret->segment = segment;
 	ret->bus = bus;
 	ret->function = function;
@@ -218,7 +223,7 @@ int pci_free_header(ARC_PCIHeaderMeta *meta) {
 	return 0;
 }
 
-static int pci_enumerate(uint16_t segment, uint8_t bus) {
+static int pci_enumerate(uint16_t segment, uint8_t bus, uint32_t node) {
 	for (int i = 0; i < 256; i++) {
 		ARC_PCIHeaderMeta *meta = pci_get_mmio_header(segment, bus, i, 0);
 
@@ -230,16 +235,26 @@ static int pci_enumerate(uint16_t segment, uint8_t bus) {
 			return -1;
 		}
 
+		meta->numa_node = node;
+
 		uint8_t type = meta->header->common.header_type & (~0x80);
 		switch (type) {
 			case ARC_PCI_HEADER_DEVICE: {
+				ARC_SnapshotPCIFunction record = {
+				        .segment = segment, .bus = bus, .device = i, .function = 0,
+				        .vendor_id = meta->header->common.vendor_id,
+				        .device_id = meta->header->common.device_id,
+				        .node = node,
+				};
+				snapshot_record(ARC_SNAPSHOT_PCI_FUNCTION, &record);
+
 				init_pci_resource(meta);
 				break;
 			}
 
 			case ARC_PCI_HEADER_PCI: {
 				uint8_t secondary = meta->header->s.pci_pci.secondary_bus;
-				pci_enumerate(segment, secondary);
+				pci_enumerate(segment, secondary, node);
 				// TODO: Insert header into some sort of list
 				// TODO: This could also be made into a device such that
 				//       it can be configured using a driver in which case,
@@ -263,6 +278,15 @@ static int pci_enumerate(uint16_t segment, uint8_t bus) {
 // NOTE: This relies on ACPI setting up MCFG space entries
 //       from least to greatest
 static int setup_mcfg() {
+	uint32_t saved = 0;
+	ARC_MCFGEntry *entries = snapshot_get(ARC_SNAPSHOT_MCFG, &saved);
+
+	if (entries != NULL && saved > 0) {
+		mcfg_space = entries;
+		mcfg_count = saved;
+		return 0;
+	}
+
 	ARC_MCFGIterator it = NULL;
 
 	while (acpi_get_next_mcfg_entry(&it) == 0) {
@@ -277,15 +301,7 @@ static int setup_mcfg() {
 	return 0;
 }
 
-int init_pci() {
-	ARC_DEBUG(INFO, "Initializing PCI\n");
-
-	int r = setup_mcfg();
-
-	if (r != 0) {
-		ARC_DEBUG(INFO, "Cannot setup memory mapped PCI access, trying to setup using I/O ports\n");
-	}
-
+static int pci_scan() {
 	ARC_PCIHeaderMeta *meta = pci_get_mmio_header(0, 0, 0, 0);
 	if (meta == NULL) {
 		meta = pci_read_header(0, 0, 0, 0);
@@ -306,14 +322,88 @@ int init_pci() {
 				break;
 			}
 
-			pci_enumerate(0, i);
+			pci_enumerate(0, i, acpi_get_pci_root_node(0, i));
 		}
 	} else {
-		pci_enumerate(0, 0);
+		pci_enumerate(0, 0, acpi_get_pci_root_node(0, 0));
 	}
 
 	pci_free_header(meta);
 
+	return 0;
+}
+
+// Bring up the functions of the snapshot, only if every one of them is still
+// in place, otherwise the buses are to be scanned
+static int pci_replay() {
+	uint32_t count = 0;
+	ARC_SnapshotPCIFunction *functions = snapshot_get(ARC_SNAPSHOT_PCI_FUNCTION, &count);
+
+	if (functions == NULL || count == 0) {
+		return -1;
+	}
+
+	ARC_PCIHeaderMeta **metas = calloc(count, sizeof(*metas));
+
+	if (metas == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate snapshot headers\n");
+		return -1;
+	}
+
+	uint32_t found = 0;
+
+	for (; found < count; found++) {
+		ARC_SnapshotPCIFunction *function = &functions[found];
+		ARC_PCIHeaderMeta *meta = pci_get_mmio_header(function->segment, function->bus, function->device, function->function);
+
+		if (meta == NULL) {
+			meta = pci_read_header(function->segment, function->bus, function->device, function->function);
+		}
+
+		if (meta == NULL || meta->header->common.vendor_id != function->vendor_id
+		    || meta->header->common.device_id != function->device_id) {
+			ARC_DEBUG(WARN, "Function at %04X:%02X:%02X.%d is not the one in the snapshot, scanning\n", function->segment,
+			          function->bus, function->device, function->function);
+
+			if (meta != NULL) {
+				pci_free_header(meta);
+			}
+
+			break;
+		}
+
+		metas[found] = meta;
+	}
+
+	for (uint32_t i = 0; i < found; i++) {
+		if (found != count) {
+			pci_free_header(metas[i]);
+			continue;
+		}
+
+		metas[i]->numa_node = functions[i].node;
+		init_pci_resource(metas[i]);
+	}
+
+	free(metas);
+
+	return found == count ? 0 : -1;
+}
+
+int init_pci() {
+	ARC_DEBUG(INFO, "Initializing PCI\n");
+
+	int r = setup_mcfg();
+
+	if (r != 0) {
+		ARC_DEBUG(INFO, "Cannot setup memory mapped PCI access, trying to setup using I/O ports\n");
+	}
+
+	// Only scan the buses if the functions are not known from a snapshot
+	if (pci_replay() != 0) {
+		snapshot_discard(ARC_SNAPSHOT_PCI_FUNCTION);
+		pci_scan();
+	}
 
 	if (r != 0) {
 		ARC_DEBUG(ERR, "Failed to initialize PCI\n");
@@ -322,5 +412,8 @@ int init_pci() {
 
 	ARC_DEBUG(INFO, "Initialized PCI\n");
 
+	// Device scopes of the DMAR are resolved through bridges
+	init_iommu();
+
 	return 0;
 }
@@ -0,0 +1,357 @@
+/**
+ * @file shootdown.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * Invalidate translations on other processors, skipping those that cannot
+ * be caching the changed page tables and deferring those that are lazy or
+ * idle until they resume, unless page tables were freed. Hand out the address
+ * space tags each processor loads page tables with.
+*/
+#include "arch/pager.h"
+#include "arch/smp.h"
+#include "global.h"
+#include "mm/allocator.h"
+
+#include <stdbool.h>
+
+struct tlb_request {
+	void *page_tables;
+	int kind;
+	uintptr_t start;
+	uintptr_t end;
+	// Processors with page_tables loaded switch away, as they are about to
+	// be deleted
+	bool release;
+	// Processors yet to acknowledge the request
+	uint32_t pending;
+};
+
+// Kept one cache line apart, as every processor writes its own on each switch
+struct tlb_processor {
+	uint32_t apic_id;
+	// 1: The processor registered itself, the fields below are valid
+	bool online;
+	int state;
+	void *page_tables;
+	// 1: A shootdown was deferred, flush everything on resume
+	uint32_t stale;
+	struct tlb_request *request;
+	// Page tables owning each tag, NULL if the tag is free or was dropped
+	void *tags[ARC_SMP_TLB_TAGS];
+	uint32_t next_tag;
+} __attribute__((aligned(64)));
+
+static struct tlb_processor *tlb_processors = NULL;
+static uint32_t tlb_processor_max = 0;
+// Slots claimed by processors registering themselves, a claimed slot is only
+// used once it is online
+static uint32_t tlb_processor_count = 0;
+// Held by the processor whose request is in flight
+static uint32_t tlb_busy = 0;
+
+static struct tlb_processor *tlb_get_self() {
+	struct tlb_processor *processors = __atomic_load_n(&tlb_processors, __ATOMIC_ACQUIRE);
+
+	if (processors == NULL) {
+		return NULL;
+	}
+
+	uint32_t apic_id = smp_get_processor_id();
+	uint32_t count = __atomic_load_n(&tlb_processor_count, __ATOMIC_ACQUIRE);
+
+	for (uint32_t i = 0; i < count && i < tlb_processor_max; i++) {
+		if (__atomic_load_n(&processors[i].online, __ATOMIC_ACQUIRE) && processors[i].apic_id == apic_id) {
+			return &processors[i];
+		}
+	}
+
+	return NULL;
+}
+
+// Claim a slot for the invoking processor, which starts out with no tags
+static struct tlb_processor *tlb_register() {
+	struct tlb_processor *processors = __atomic_load_n(&tlb_processors, __ATOMIC_ACQUIRE);
+
+	if (processors == NULL) {
+		return NULL;
+	}
+
+	uint32_t index = __atomic_fetch_add(&tlb_processor_count, 1, __ATOMIC_ACQ_REL);
+
+	if (index >= tlb_processor_max) {
+		ARC_DEBUG(ERR, "No TLB tracking left for processor %d\n", smp_get_processor_id());
+		return NULL;
+	}
+
+	struct tlb_processor *self = &processors[index];
+	self->apic_id = smp_get_processor_id();
+	self->state = ARC_SMP_TLB_ACTIVE;
+	self->page_tables = (void *)Arc_KernelPageTables;
+	__atomic_store_n(&self->online, true, __ATOMIC_SEQ_CST);
+
+	return self;
+}
+
+// Drop the tag of page_tables on a processor, returns 1 if it had one
+static int tlb_drop_tag(struct tlb_processor *processor, void *page_tables) {
+	for (int i = 0; i < ARC_SMP_TLB_TAGS; i++) {
+		void *expected = page_tables;
+
+		if (__atomic_compare_exchange_n(&processor->tags[i], &expected, NULL, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+uint32_t smp_tlb_switch(void *page_tables, bool *flush) {
+	struct tlb_processor *self = tlb_get_self();
+
+	*flush = true;
+
+	if (self == NULL && (self = tlb_register()) == NULL) {
+		return 0;
+	}
+
+	// Pairs with the dropping in smp_tlb_shootdown, either the sender sees
+	// the tables loaded or this processor sees the tag dropped
+	__atomic_store_n(&self->page_tables, page_tables, __ATOMIC_SEQ_CST);
+
+	for (int i = 0; i < ARC_SMP_TLB_TAGS; i++) {
+		if (__atomic_load_n(&self->tags[i], __ATOMIC_SEQ_CST) == page_tables) {
+			*flush = false;
+			return i + 1;
+		}
+	}
+
+	uint32_t tag = self->next_tag;
+	self->next_tag = (tag + 1) % ARC_SMP_TLB_TAGS;
+	__atomic_store_n(&self->tags[tag], page_tables, __ATOMIC_SEQ_CST);
+
+	return tag + 1;
+}
+
+void smp_tlb_forget(void *page_tables) {
+	struct tlb_processor *processors = __atomic_load_n(&tlb_processors, __ATOMIC_ACQUIRE);
+
+	if (processors == NULL) {
+		return;
+	}
+
+	uint32_t count = __atomic_load_n(&tlb_processor_count, __ATOMIC_ACQUIRE);
+
+	for (uint32_t i = 0; i < count && i < tlb_processor_max; i++) {
+		if (__atomic_load_n(&processors[i].online, __ATOMIC_ACQUIRE)) {
+			tlb_drop_tag(&processors[i], page_tables);
+		}
+	}
+}
+
+void smp_tlb_enter(int state) {
+	struct tlb_processor *self = tlb_get_self();
+
+	if (self == NULL) {
+		return;
+	}
+
+	__atomic_store_n(&self->state, state, __ATOMIC_SEQ_CST);
+}
+
+void smp_tlb_resume() {
+	struct tlb_processor *self = tlb_get_self();
+
+	if (self == NULL) {
+		return;
+	}
+
+	// Pairs with the marking in smp_tlb_shootdown, either the sender sees
+	// this processor active or this processor sees the mark
+	__atomic_store_n(&self->state, ARC_SMP_TLB_ACTIVE, __ATOMIC_SEQ_CST);
+
+	if (__atomic_exchange_n(&self->stale, 0, __ATOMIC_SEQ_CST) != 0) {
+		pager_flush_local(ARC_PAGER_FLUSH_ALL, 0, 0);
+	}
+}
+
+// Load the kernel page tables on the invoking processor if it has page_tables
+// loaded
+static void tlb_leave(struct tlb_processor *self, void *page_tables) {
+	if (__atomic_load_n(&self->page_tables, __ATOMIC_SEQ_CST) != page_tables) {
+		return;
+	}
+
+	bool flush = true;
+	uint32_t tag = smp_tlb_switch((void *)Arc_KernelPageTables, &flush);
+	pager_load_local((void *)Arc_KernelPageTables, tag, flush);
+}
+
+void smp_tlb_handle_shootdown() {
+	struct tlb_processor *self = tlb_get_self();
+
+	if (self == NULL) {
+		return;
+	}
+
+	struct tlb_request *request = __atomic_exchange_n(&self->request, NULL, __ATOMIC_ACQ_REL);
+
+	if (request == NULL) {
+		return;
+	}
+
+	pager_flush_local(request->kind, request->start, request->end);
+
+	if (request->release) {
+		tlb_leave(self, request->page_tables);
+	}
+
+	__atomic_sub_fetch(&request->pending, 1, __ATOMIC_RELEASE);
+}
+
+static int tlb_shootdown(void *page_tables, int kind, uintptr_t start, uintptr_t end, bool freed_tables, bool release) {
+	if (kind != ARC_PAGER_FLUSH_ALL && start >= end) {
+		return 0;
+	}
+
+	struct tlb_processor *self = tlb_get_self();
+
+	if (self == NULL) {
+		// Before the invoking processor registers with its first
+		// smp_tlb_switch, no other processor is running
+		pager_flush_local(kind, start, end);
+		return 0;
+	}
+
+	bool global = (uintptr_t)page_tables == Arc_KernelPageTables;
+	// Kernel mappings are used by lazy processors too
+	int deferred = global ? ARC_SMP_TLB_IDLE : ARC_SMP_TLB_LAZY;
+
+	if (freed_tables) {
+		// Processors that have the tables loaded may walk them at any time,
+		// lazy and idle ones included, so none are deferred
+		deferred = ARC_SMP_TLB_IDLE + 1;
+	}
+	struct tlb_request request = { .page_tables = page_tables, .kind = kind, .start = start, .end = end, .release = release };
+
+	// Keep serving requests sent to this processor while another is in
+	// flight, the sender may be waiting on this processor
+	while (__atomic_exchange_n(&tlb_busy, 1, __ATOMIC_ACQUIRE) != 0) {
+		smp_tlb_handle_shootdown();
+#ifdef ARC_TARGET_ARCH_X86_64
+		__builtin_ia32_pause();
+#endif
+	}
+
+	uint32_t count = __atomic_load_n(&tlb_processor_count, __ATOMIC_ACQUIRE);
+
+	for (uint32_t i = 0; i < count && i < tlb_processor_max; i++) {
+		struct tlb_processor *processor = &tlb_processors[i];
+
+		// A processor coming online loads its first tables with a flush
+		if (processor == self || !__atomic_load_n(&processor->online, __ATOMIC_ACQUIRE)) {
+			continue;
+		}
+
+		// A processor running other tables only needs to forget the tag of
+		// these, unless it switched to them in the meantime
+		if (!global && __atomic_load_n(&processor->page_tables, __ATOMIC_SEQ_CST) != page_tables
+		    && (tlb_drop_tag(processor, page_tables) == 0
+		        || __atomic_load_n(&processor->page_tables, __ATOMIC_SEQ_CST) != page_tables)) {
+			continue;
+		}
+
+		uint32_t marked = __atomic_exchange_n(&processor->stale, 1, __ATOMIC_SEQ_CST);
+
+		if (__atomic_load_n(&processor->state, __ATOMIC_SEQ_CST) >= deferred) {
+			continue;
+		}
+
+		// The IPI covers the change, take the mark back unless an earlier
+		// request was deferred
+		if (marked == 0) {
+			__atomic_store_n(&processor->stale, 0, __ATOMIC_RELAXED);
+		}
+
+		__atomic_add_fetch(&request.pending, 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&processor->request, &request, __ATOMIC_RELEASE);
+
+		if (smp_send_tlb_ipi(processor->apic_id) != 0) {
+			ARC_DEBUG(ERR, "Failed to send shootdown to processor %d, deferring\n", processor->apic_id);
+			__atomic_store_n(&processor->request, NULL, __ATOMIC_RELAXED);
+			__atomic_store_n(&processor->stale, 1, __ATOMIC_SEQ_CST);
+			__atomic_sub_fetch(&request.pending, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	if (global || __atomic_load_n(&self->page_tables, __ATOMIC_RELAXED) == page_tables) {
+		pager_flush_local(kind, start, end);
+
+		if (release) {
+			tlb_leave(self, page_tables);
+		}
+	} else {
+		tlb_drop_tag(self, page_tables);
+	}
+
+	while (__atomic_load_n(&request.pending, __ATOMIC_ACQUIRE) > 0) {
+#ifdef ARC_TARGET_ARCH_X86_64
+		__builtin_ia32_pause();
+#endif
+	}
+
+	__atomic_store_n(&tlb_busy, 0, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+int smp_tlb_shootdown(void *page_tables, int kind, uintptr_t start, uintptr_t end, bool freed_tables) {
+	return tlb_shootdown(page_tables, kind, start, end, freed_tables, false);
+}
+
+int smp_tlb_release(void *page_tables) {
+	// Lazy and idle processors with the tables loaded are interrupted as for
+	// freed tables
+	int ret = tlb_shootdown(page_tables, ARC_PAGER_FLUSH_ALL, 0, 0, true, true);
+	smp_tlb_forget(page_tables);
+
+	return ret;
+}
+
+int init_smp_tlb(uint32_t max) {
+	if (max == 0) {
+		ARC_DEBUG(ERR, "No processors to track TLBs of\n");
+		return -1;
+	}
+
+	struct tlb_processor *processors = calloc(max, sizeof(*processors));
+
+	if (processors == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate TLB tracking\n");
+		return -1;
+	}
+
+	tlb_processor_max = max;
+	__atomic_store_n(&tlb_processors, processors, __ATOMIC_RELEASE);
+
+	return 0;
+}
@@ -0,0 +1,319 @@
+/**
+ * @file snapshot.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Serialize the decoded platform state into a versioned, checksummed blob, and
+ * validate such blobs against the ACPI tables of the current boot.
+*/
+#include "arch/acpi/table.h"
+#include "arch/smp.h"
+#include "arch/snapshot.h"
+#include "global.h"
+#include "lib/hash.h"
+#include "lib/util.h"
+#include "mm/allocator.h"
+
+#define SNAPSHOT_ALIGN 8
+#define SNAPSHOT_PAD(__size) (((__size) + SNAPSHOT_ALIGN - 1) & ~(size_t)(SNAPSHOT_ALIGN - 1))
+#define SNAPSHOT_SDT_HEADER_SIZE 36
+// Offsets of the DSDT address in the FADT, which is not listed in the XSDT
+#define SNAPSHOT_FADT_DSDT 40
+#define SNAPSHOT_FADT_X_DSDT 140
+
+struct snapshot_rsdp {
+	char signature[8];
+	uint8_t checksum;
+	char oem_id[6];
+	uint8_t revision;
+	uint32_t rsdt;
+	uint32_t length;
+	uint64_t xsdt;
+	uint8_t extended_checksum;
+	uint8_t resv0[3];
+} __attribute__((packed));
+
+struct snapshot_buffer {
+	void *records;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+static const uint32_t snapshot_record_sizes[ARC_SNAPSHOT_SECTION_MAX] = {
+	[ARC_SNAPSHOT_TOPOLOGY] = sizeof(ARC_ProcessorTopology),
+	[ARC_SNAPSHOT_MCFG] = sizeof(ARC_MCFGEntry),
+	[ARC_SNAPSHOT_PCI_ROOT] = sizeof(ARC_SnapshotPCIRoot),
+	[ARC_SNAPSHOT_PCI_FUNCTION] = sizeof(ARC_SnapshotPCIFunction),
+	[ARC_SNAPSHOT_ACPI_DEVICE] = sizeof(ARC_SnapshotACPIDevice),
+	[ARC_SNAPSHOT_ACPI_IO] = sizeof(ARC_SnapshotACPIIO),
+	[ARC_SNAPSHOT_ACPI_IRQ] = sizeof(ARC_SnapshotACPIIRQ),
+};
+
+static ARC_SnapshotHeader *snapshot_loaded = NULL;
+// Sections of the loaded snapshot found stale, by bit
+static uint32_t snapshot_discarded = 0;
+static struct snapshot_buffer snapshot_recorded[ARC_SNAPSHOT_SECTION_MAX] = { 0 };
+
+static uint64_t snapshot_combine(uint64_t hash, uint64_t value) {
+	return hash ^ (value + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2));
+}
+
+static uint64_t snapshot_hash_table(uint64_t hash, uint64_t phys) {
+	if (phys == 0) {
+		return hash;
+	}
+
+	return snapshot_combine(hash, hash_fnv1a((uint8_t *)ARC_PHYS_TO_HHDM(phys), SNAPSHOT_SDT_HEADER_SIZE));
+}
+
+uint64_t snapshot_fingerprint() {
+	if (Arc_KernelMeta->rsdp == 0) {
+		return 0;
+	}
+
+	struct snapshot_rsdp *rsdp = (struct snapshot_rsdp *)ARC_PHYS_TO_HHDM(Arc_KernelMeta->rsdp);
+	bool extended = rsdp->revision >= 2 && rsdp->xsdt != 0;
+	uint64_t root_phys = extended ? rsdp->xsdt : rsdp->rsdt;
+	uint8_t *root = (uint8_t *)ARC_PHYS_TO_HHDM(root_phys);
+	uint32_t length = *(uint32_t *)(root + 4);
+	size_t entry_size = extended ? sizeof(uint64_t) : sizeof(uint32_t);
+
+	uint64_t hash = snapshot_hash_table(hash_fnv1a((uint8_t *)rsdp, sizeof(*rsdp)), root_phys);
+
+	for (size_t i = SNAPSHOT_SDT_HEADER_SIZE; i + entry_size <= length; i += entry_size) {
+		uint64_t phys = extended ? *(uint64_t *)(root + i) : *(uint32_t *)(root + i);
+		hash = snapshot_hash_table(hash, phys);
+
+		uint8_t *table = (uint8_t *)ARC_PHYS_TO_HHDM(phys);
+		uint32_t table_length = *(uint32_t *)(table + 4);
+
+		if (memcmp(table, "FACP", 4) != 0) {
+			continue;
+		}
+
+		uint64_t dsdt = *(uint32_t *)(table + SNAPSHOT_FADT_DSDT);
+
+		if (table_length >= SNAPSHOT_FADT_X_DSDT + sizeof(uint64_t) && *(uint64_t *)(table + SNAPSHOT_FADT_X_DSDT) != 0) {
+			dsdt = *(uint64_t *)(table + SNAPSHOT_FADT_X_DSDT);
+		}
+
+		hash = snapshot_hash_table(hash, dsdt);
+	}
+
+	return hash;
+}
+
+int snapshot_load(void *blob, size_t size) {
+	ARC_SnapshotHeader *header = blob;
+
+	if (blob == NULL || size < sizeof(*header)) {
+		return -1;
+	}
+
+	if (header->magic != ARC_SNAPSHOT_MAGIC || header->version != ARC_SNAPSHOT_VERSION) {
+		ARC_DEBUG(WARN, "Snapshot is not of version %d\n", ARC_SNAPSHOT_VERSION);
+		return -1;
+	}
+
+	if (header->size < sizeof(*header) || header->size > size
+	    || hash_fnv1a((uint8_t *)blob + sizeof(*header), header->size - sizeof(*header)) != header->checksum) {
+		ARC_DEBUG(WARN, "Snapshot is corrupt\n");
+		return -1;
+	}
+
+	for (int i = 0; i < ARC_SNAPSHOT_SECTION_MAX; i++) {
+		ARC_SnapshotSection *section = &header->sections[i];
+
+		if (section->record_size != snapshot_record_sizes[i] || section->offset % SNAPSHOT_ALIGN != 0
+		    || section->offset < sizeof(*header)
+		    || (uint64_t)section->offset + (uint64_t)section->count * section->record_size > header->size) {
+			ARC_DEBUG(WARN, "Snapshot section %d is malformed\n", i);
+			return -1;
+		}
+	}
+
+	if (header->fingerprint != snapshot_fingerprint()) {
+		ARC_DEBUG(INFO, "ACPI tables changed since the snapshot was taken\n");
+		return -1;
+	}
+
+	snapshot_loaded = header;
+
+	ARC_DEBUG(INFO, "Using snapshot of %d bytes\n", header->size);
+
+	return 0;
+}
+
+void *snapshot_get(int section, uint32_t *count) {
+	if (snapshot_loaded == NULL || section < 0 || section >= ARC_SNAPSHOT_SECTION_MAX
+	    || (snapshot_discarded & (1 << section)) != 0) {
+		return NULL;
+	}
+
+	if (count != NULL) {
+		*count = snapshot_loaded->sections[section].count;
+	}
+
+	return (uint8_t *)snapshot_loaded + snapshot_loaded->sections[section].offset;
+}
+
+int snapshot_record(int section, const void *record) {
+	if (section < 0 || section >= ARC_SNAPSHOT_SECTION_MAX || record == NULL) {
+		return -1;
+	}
+
+	if (snapshot_loaded != NULL && (snapshot_discarded & (1 << section)) == 0) {
+		return 0;
+	}
+
+	struct snapshot_buffer *buffer = &snapshot_recorded[section];
+	uint32_t size = snapshot_record_sizes[section];
+
+	if (buffer->count == buffer->capacity) {
+		uint32_t capacity = buffer->capacity == 0 ? 16 : buffer->capacity * 2;
+		void *records = alloc(capacity * size);
+
+		if (records == NULL) {
+			ARC_DEBUG(ERR, "Failed to grow snapshot section %d\n", section);
+			return -1;
+		}
+
+		if (buffer->records != NULL) {
+			memcpy(records, buffer->records, buffer->count * size);
+			free(buffer->records);
+		}
+
+		buffer->records = records;
+		buffer->capacity = capacity;
+	}
+
+	memcpy((uint8_t *)buffer->records + buffer->count * size, record, size);
+	buffer->count++;
+
+	return 0;
+}
+
+void snapshot_discard(int section) {
+	if (snapshot_loaded == NULL || section < 0 || section >= ARC_SNAPSHOT_SECTION_MAX
+	    || (snapshot_discarded & (1 << section)) != 0) {
+		return;
+	}
+
+	snapshot_discarded |= 1 << section;
+
+	ARC_DEBUG(INFO, "Snapshot section %d is stale, recording it anew\n", section);
+}
+
+// Records of a section as they will be saved
+static void *snapshot_source(int section, uint32_t *count) {
+	*count = 0;
+
+	switch (section) {
+		case ARC_SNAPSHOT_TOPOLOGY: {
+			*count = smp_get_topology_count();
+			return *count > 0 ? smp_get_topology(0) : NULL;
+		}
+
+		case ARC_SNAPSHOT_MCFG: {
+			ARC_MCFGIterator it = NULL;
+			ARC_MCFGEntry *first = NULL;
+
+			while (acpi_get_next_mcfg_entry(&it) == 0) {
+				if (first == NULL) {
+					first = it;
+				}
+
+				(*count)++;
+			}
+
+			return first;
+		}
+
+		default: {
+			void *records = snapshot_get(section, count);
+
+			if (records != NULL) {
+				return records;
+			}
+
+			*count = snapshot_recorded[section].count;
+			return snapshot_recorded[section].records;
+		}
+	}
+}
+
+size_t snapshot_save(void **out) {
+	if (out == NULL) {
+		return 0;
+	}
+
+	void *sources[ARC_SNAPSHOT_SECTION_MAX] = { 0 };
+	uint32_t counts[ARC_SNAPSHOT_SECTION_MAX] = { 0 };
+	size_t size = SNAPSHOT_PAD(sizeof(ARC_SnapshotHeader));
+
+	for (int i = 0; i < ARC_SNAPSHOT_SECTION_MAX; i++) {
+		sources[i] = snapshot_source(i, &counts[i]);
+		size += SNAPSHOT_PAD((size_t)counts[i] * snapshot_record_sizes[i]);
+	}
+
+	if (size > UINT32_MAX) {
+		ARC_DEBUG(ERR, "Snapshot is too large\n");
+		return 0;
+	}
+
+	uint8_t *blob = alloc(size);
+
+	if (blob == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate snapshot\n");
+		return 0;
+	}
+
+	memset(blob, 0, size);
+
+	ARC_SnapshotHeader *header = (ARC_SnapshotHeader *)blob;
+	size_t offset = SNAPSHOT_PAD(sizeof(*header));
+
+	for (int i = 0; i < ARC_SNAPSHOT_SECTION_MAX; i++) {
+		size_t length = (size_t)counts[i] * snapshot_record_sizes[i];
+
+		header->sections[i].offset = offset;
+		header->sections[i].count = counts[i];
+		header->sections[i].record_size = snapshot_record_sizes[i];
+
+		if (length > 0) {
+			memcpy(blob + offset, sources[i], length);
+		}
+
+		offset += SNAPSHOT_PAD(length);
+	}
+
+	header->magic = ARC_SNAPSHOT_MAGIC;
+	header->version = ARC_SNAPSHOT_VERSION;
+	header->size = size;
+	header->fingerprint = snapshot_fingerprint();
+	header->checksum = hash_fnv1a(blob + sizeof(*header), size - sizeof(*header));
+
+	*out = blob;
+
+	return size;
+}
@@ -0,0 +1,254 @@
+/**
+ * @file tablepool.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * Per processor pools of zeroed pages for page tables. Freed tables are kept
+ * dirty and zeroed by processors about to idle, so that allocating a table
+ * is a pop off a stack.
+*/
+#include "arch/pager.h"
+#include "arch/smp.h"
+#include "global.h"
+#include "mm/allocator.h"
+
+#define POOL_TABLE_SIZE 0x1000
+// Zeroed tables a processor keeps at most
+#define POOL_MAGAZINE 64
+// Tables taken from the allocator at once when the pool runs dry
+#define POOL_REFILL 16
+// Dirty tables a processor keeps before returning the rest to the allocator
+#define POOL_DIRTY_MAX 256
+
+struct pool_processor {
+	uint32_t apic_id;
+	// 1: The processor registered itself, the fields below are valid
+	bool online;
+	// Taken by the processor while it uses the pool, if already taken (i.e.
+	// by an interrupted use) the allocator is used directly
+	uint32_t busy;
+	void *zeroed[POOL_MAGAZINE];
+	uint32_t zeroed_count;
+	// Linked through the first word of each table
+	void *dirty;
+	uint32_t dirty_count;
+} __attribute__((aligned(64)));
+
+static struct pool_processor *pool_processors = NULL;
+static uint32_t pool_processor_max = 0;
+// Slots claimed by processors registering themselves
+static uint32_t pool_processor_count = 0;
+
+// Get the pool of the invoking processor, claiming a slot for it on first use
+static struct pool_processor *pool_acquire() {
+	struct pool_processor *processors = __atomic_load_n(&pool_processors, __ATOMIC_ACQUIRE);
+
+	if (processors == NULL) {
+		return NULL;
+	}
+
+	uint32_t apic_id = smp_get_processor_id();
+	uint32_t count = __atomic_load_n(&pool_processor_count, __ATOMIC_ACQUIRE);
+	struct pool_processor *pool = NULL;
+
+	for (uint32_t i = 0; i < count && i < pool_processor_max; i++) {
+		if (__atomic_load_n(&processors[i].online, __ATOMIC_ACQUIRE) && processors[i].apic_id == apic_id) {
+			pool = &processors[i];
+			break;
+		}
+	}
+
+	if (pool == NULL) {
+		uint32_t index = __atomic_fetch_add(&pool_processor_count, 1, __ATOMIC_ACQ_REL);
+
+		if (index >= pool_processor_max) {
+			return NULL;
+		}
+
+		pool = &processors[index];
+		pool->apic_id = apic_id;
+		__atomic_store_n(&pool->online, true, __ATOMIC_RELEASE);
+	}
+
+	if (__atomic_exchange_n(&pool->busy, 1, __ATOMIC_ACQUIRE) != 0) {
+		return NULL;
+	}
+
+	return pool;
+}
+
+static void pool_release(struct pool_processor *pool) {
+	__atomic_store_n(&pool->busy, 0, __ATOMIC_RELEASE);
+}
+
+static void *pool_pop_dirty(struct pool_processor *pool) {
+	void *table = pool->dirty;
+
+	if (table != NULL) {
+		pool->dirty = *(void **)table;
+		pool->dirty_count--;
+	}
+
+	return table;
+}
+
+// Fill the magazine with up to count tables, dirty ones first, then fresh
+// ones from the allocator
+static uint32_t pool_fill(struct pool_processor *pool, uint32_t count) {
+	uint32_t filled = 0;
+
+	while (filled < count && pool->zeroed_count < POOL_MAGAZINE) {
+		void *table = pool_pop_dirty(pool);
+
+		if (table == NULL) {
+			table = alloc(POOL_TABLE_SIZE);
+		}
+
+		if (table == NULL) {
+			break;
+		}
+
+		memset(table, 0, POOL_TABLE_SIZE);
+		pool->zeroed[pool->zeroed_count++] = table;
+		filled++;
+	}
+
+	return filled;
+}
+
+void *pager_alloc_table() {
+	struct pool_processor *pool = pool_acquire();
+
+	if (pool == NULL) {
+		void *table = alloc(POOL_TABLE_SIZE);
+
+		if (table != NULL) {
+			memset(table, 0, POOL_TABLE_SIZE);
+		}
+
+		return table;
+	}
+
+	if (pool->zeroed_count == 0) {
+		pool_fill(pool, POOL_REFILL);
+	}
+
+	void *table = NULL;
+
+	if (pool->zeroed_count > 0) {
+		table = pool->zeroed[--pool->zeroed_count];
+	}
+
+	pool_release(pool);
+
+	return table;
+}
+
+int pager_free_tables(void *tables) {
+	if (tables == NULL) {
+		return 0;
+	}
+
+	struct pool_processor *pool = pool_acquire();
+
+	if (pool == NULL) {
+		while (tables != NULL) {
+			void *next = *(void **)tables;
+			free(tables);
+			tables = next;
+		}
+
+		return 0;
+	}
+
+	// Splice the list in front of the dirty tables
+	void *last = tables;
+	uint32_t count = 1;
+
+	while (*(void **)last != NULL) {
+		last = *(void **)last;
+		count++;
+	}
+
+	*(void **)last = pool->dirty;
+	pool->dirty = tables;
+	pool->dirty_count += count;
+
+	while (pool->dirty_count > POOL_DIRTY_MAX) {
+		free(pool_pop_dirty(pool));
+	}
+
+	pool_release(pool);
+
+	return count;
+}
+
+int pager_free_table(void *table) {
+	if (table == NULL) {
+		return -1;
+	}
+
+	*(void **)table = NULL;
+
+	return pager_free_tables(table) > 0 ? 0 : -1;
+}
+
+int pager_zero_tables(uint32_t max) {
+	struct pool_processor *pool = pool_acquire();
+
+	if (pool == NULL) {
+		return 0;
+	}
+
+	uint32_t filled = 0;
+
+	// Only zero what was freed, idle time should not grow the pool
+	while (filled < max && pool->dirty != NULL && pool->zeroed_count < POOL_MAGAZINE) {
+		void *table = pool_pop_dirty(pool);
+		memset(table, 0, POOL_TABLE_SIZE);
+		pool->zeroed[pool->zeroed_count++] = table;
+		filled++;
+	}
+
+	pool_release(pool);
+
+	return filled;
+}
+
+int init_pager_pool(uint32_t max) {
+	if (max == 0) {
+		ARC_DEBUG(ERR, "No processors to pool page tables for\n");
+		return -1;
+	}
+
+	struct pool_processor *processors = calloc(max, sizeof(*processors));
+
+	if (processors == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate page table pools\n");
+		return -1;
+	}
+
+	pool_processor_max = max;
+	__atomic_store_n(&pool_processors, processors, __ATOMIC_RELEASE);
+
+	return 0;
+}
@@ -0,0 +1,251 @@
+/**
+ * @file topology.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Build the core, cache and package topology of the processors listed in the
+ * MADT from the PPTT, or from their APIC IDs if there is no PPTT.
+*/
+#include "arch/acpi/table.h"
+#include "arch/numa.h"
+#include "arch/smp.h"
+#include "arch/snapshot.h"
+#include "global.h"
+#include "mm/allocator.h"
+
+static ARC_ProcessorTopology *topology = NULL;
+static uint32_t topology_count = 0;
+
+uint32_t smp_get_topology_count() {
+	return topology_count;
+}
+
+ARC_ProcessorTopology *smp_get_topology(uint32_t index) {
+	if (index >= topology_count) {
+		return NULL;
+	}
+
+	return &topology[index];
+}
+
+ARC_ProcessorTopology *smp_get_topology_by_uid(uint32_t acpi_uid) {
+	for (uint32_t i = 0; i < topology_count; i++) {
+		if (topology[i].acpi_uid == acpi_uid) {
+			return &topology[i];
+		}
+	}
+
+	return NULL;
+}
+
+static int smp_get_siblings(uint32_t acpi_uid, uint32_t *out, uint32_t max, size_t field) {
+	ARC_ProcessorTopology *self = smp_get_topology_by_uid(acpi_uid);
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	uint32_t id = *(uint32_t *)((uintptr_t)self + field);
+	int count = 0;
+
+	for (uint32_t i = 0; i < topology_count; i++) {
+		ARC_ProcessorTopology *other = &topology[i];
+
+		if (other == self || *(uint32_t *)((uintptr_t)other + field) != id) {
+			continue;
+		}
+
+		if (out != NULL && (uint32_t)count < max) {
+			out[count] = other->acpi_uid;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+int smp_get_llc_siblings(uint32_t acpi_uid, uint32_t *out, uint32_t max) {
+	return smp_get_siblings(acpi_uid, out, max, offsetof(ARC_ProcessorTopology, llc));
+}
+
+int smp_get_smt_siblings(uint32_t acpi_uid, uint32_t *out, uint32_t max) {
+	return smp_get_siblings(acpi_uid, out, max, offsetof(ARC_ProcessorTopology, core));
+}
+
+static bool topology_has_unified_cache(ARC_PPTTProcessor *processor) {
+	uint32_t *resources = (uint32_t *)(processor + 1);
+
+	for (uint32_t i = 0; i < processor->private_count; i++) {
+		ARC_PPTTEntry *entry = acpi_get_pptt_entry(resources[i]);
+
+		if (entry != NULL && entry->type == ARC_PPTT_ENTRY_TYPE_CACHE
+		    && ARC_PPTT_CACHE_TYPE(entry->d.cache.attributes) >= 2) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int topology_from_pptt(ARC_ProcessorTopology *processor) {
+	ARC_PPTTIterator it = NULL;
+	ARC_PPTTProcessor *leaf = NULL;
+
+	while ((leaf = acpi_get_next_pptt_entry(ARC_PPTT_ENTRY_TYPE_PROCESSOR, &it)) != NULL) {
+		if ((leaf->flags & ARC_PPTT_PROCESSOR_ID_VALID) && leaf->acpi_id == processor->acpi_uid) {
+			break;
+		}
+	}
+
+	if (leaf == NULL) {
+		return -1;
+	}
+
+	uint32_t offset = acpi_get_pptt_offset(it);
+
+	// Threads are described as children of their core
+	processor->core = (leaf->flags & ARC_PPTT_PROCESSOR_THREAD) ? leaf->parent : offset;
+	processor->llc = offset;
+	processor->package = offset;
+
+	// The last level cache belongs to the outermost node that has a unified
+	// cache as a private resource
+	ARC_PPTTProcessor *node = leaf;
+	for (int depth = 0; node != NULL && depth < 16; depth++) {
+		if (topology_has_unified_cache(node)) {
+			processor->llc = offset;
+		}
+
+		if (node->flags & ARC_PPTT_PROCESSOR_PACKAGE) {
+			processor->package = offset;
+			break;
+		}
+
+		ARC_PPTTEntry *parent = acpi_get_pptt_entry(node->parent);
+
+		if (node->parent == 0 || parent == NULL || parent->type != ARC_PPTT_ENTRY_TYPE_PROCESSOR) {
+			break;
+		}
+
+		offset = node->parent;
+		node = &parent->d.processor;
+	}
+
+	return 0;
+}
+
+static void topology_from_apic_id(ARC_ProcessorTopology *processor, uint32_t smt_shift, uint32_t llc_shift, uint32_t package_shift) {
+	processor->core = processor->apic_id >> smt_shift;
+	processor->llc = processor->apic_id >> llc_shift;
+	processor->package = processor->apic_id >> package_shift;
+}
+
+static void topology_add(uint32_t acpi_uid, uint32_t apic_id) {
+	ARC_ProcessorTopology *processor = &topology[topology_count++];
+
+	processor->acpi_uid = acpi_uid;
+	processor->apic_id = apic_id;
+	processor->node = numa_get_processor_node(apic_id);
+}
+
+int init_smp_topology() {
+	uint32_t count = 0;
+	ARC_ProcessorTopology *saved = snapshot_get(ARC_SNAPSHOT_TOPOLOGY, &count);
+
+	if (saved != NULL && count > 0) {
+		topology = saved;
+		topology_count = count;
+		return 0;
+	}
+
+	count = 0;
+	ARC_MADTIterator it = NULL;
+
+	while (acpi_get_next_madt_entry(ARC_MADT_ENTRY_TYPE_LAPIC, &it) != NULL) {
+		count++;
+	}
+	while (acpi_get_next_madt_entry(ARC_MADT_ENTRY_TYPE_Lx2APIC, &it) != NULL) {
+		count++;
+	}
+
+	if (count == 0) {
+		ARC_DEBUG(ERR, "No processors in the MADT\n");
+		return -1;
+	}
+
+	topology = alloc(count * sizeof(*topology));
+
+	if (topology == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate topology\n");
+		return -1;
+	}
+
+	memset(topology, 0, count * sizeof(*topology));
+
+	// Bit 0: Enabled, bit 1: Online capable
+	ARC_MADTLapic *lapic = NULL;
+	while ((lapic = acpi_get_next_madt_entry(ARC_MADT_ENTRY_TYPE_LAPIC, &it)) != NULL) {
+		if (lapic->flags & 0b11) {
+			topology_add(lapic->uid, lapic->id);
+		}
+	}
+
+	ARC_MADTx2Apic *x2apic = NULL;
+	while ((x2apic = acpi_get_next_madt_entry(ARC_MADT_ENTRY_TYPE_Lx2APIC, &it)) != NULL) {
+		if (x2apic->flags & 0b11) {
+			topology_add(x2apic->uid, x2apic->id);
+		}
+	}
+
+	uint32_t smt_shift = 0;
+	uint32_t llc_shift = 0;
+	uint32_t package_shift = 0;
+	bool have_shifts = smp_get_apic_id_shifts(&smt_shift, &llc_shift, &package_shift) == 0;
+	uint32_t described = 0;
+
+	for (uint32_t i = 0; i < topology_count; i++) {
+		if (topology_from_pptt(&topology[i]) == 0) {
+			described++;
+		}
+	}
+
+	// PPTT offsets and APIC ID derived identifiers cannot be compared, so
+	// unless the PPTT describes every processor it is not used at all
+	for (uint32_t i = 0; described != topology_count && i < topology_count; i++) {
+		if (have_shifts) {
+			topology_from_apic_id(&topology[i], smt_shift, llc_shift, package_shift);
+		} else {
+			// Nothing is known, treat every processor as its own core
+			// in a single package
+			topology[i].core = topology[i].apic_id;
+			topology[i].llc = topology[i].apic_id;
+			topology[i].package = 0;
+		}
+	}
+
+	ARC_DEBUG(INFO, "Topology of %d processors, %d described by the PPTT%s\n", topology_count, described,
+		  described != topology_count ? ", using APIC IDs instead" : "");
+
+	return 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file translate.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/Karch - Abstract Definition, Declaration of Architecture Functions
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/Karch.
+ *
+ * Arctan-OS/Karch is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * Translate virtual ranges into physically contiguous extents.
+*/
+#include "arch/pager.h"
+#include "global.h"
+
+int pager_translate_range(void *page_tables, uintptr_t virtual, size_t size, ARC_PagerExtent *extents, int max) {
+	if (extents == NULL || max <= 0) {
+		return 0;
+	}
+
+	int count = 0;
+
+	while (size > 0) {
+		ARC_PagerTranslation translation = { 0 };
+
+		if (pager_translate(page_tables, virtual, &translation) != 0) {
+			break;
+		}
+
+		// Rest of the page the address lies in
+		size_t length = translation.page_size - (virtual & (translation.page_size - 1));
+
+		if (length > size) {
+			length = size;
+		}
+
+		ARC_PagerExtent *last = count > 0 ? &extents[count - 1] : NULL;
+
+		if (last != NULL && last->physical + last->size == translation.physical) {
+			last->size += length;
+		} else if (count < max) {
+			extents[count++] = (ARC_PagerExtent){ .virtual = virtual, .physical = translation.physical, .size = length };
+		} else {
+			break;
+		}
+
+		virtual += length;
+		size -= length;
+	}
+
+	return count;
+}